@@ -0,0 +1,637 @@
+/*	Function discovery, basic blocks and call graphs; see analysis.h. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "analysis.h"
+#include "dis68k.h"
+#include "parallel.h"
+#include "registers.h"
+
+namespace {
+
+/* An instruction reached while scanning a function. */
+struct Step {
+	uint32_t address;
+	uint32_t target;
+	uint8_t length;
+	uint8_t flow;
+	bool has_target;
+	uint16_t cases;			// for a JMP through a jump table: the number of its targets
+	uint32_t first_case;	// and where they start in Scan::cases
+};
+
+/* A function as decoded by one worker: its blocks, with successors as local block indices. */
+struct Scan {
+	uint32_t entry;
+	uint8_t origin;
+	bool clean;								// no undecodable word was reached
+	bool returns;
+
+	std::vector<BasicBlock> blocks;
+	std::vector<uint32_t> successor_offsets;
+	std::vector<uint32_t> successors;
+	std::vector<std::pair<uint32_t, uint8_t>> callees;	// address and FunctionOrigin
+	std::vector<JumpTable> tables;
+	std::vector<uint32_t> cases;
+	std::vector<Reference> references;
+};
+
+/* A prologue that runs into data, or never reaches a return, was probably data itself. */
+bool spurious(const Scan &scan) {
+	return scan.origin == OriginPrologue && !(scan.clean && scan.returns);
+}
+
+/* Bcc conditions. */
+enum {
+	ConditionHI = 2,
+	ConditionCC = 4,
+	ConditionGE = 12,
+	ConditionGT = 14
+};
+
+/* How many instructions before a JMP are searched for the table load and the bounds check. */
+const unsigned int dispatch_window = 8;
+
+/* @returns The register, 0 to 15 for D0 to A7, that an index byte names. */
+unsigned int index_register(uint8_t index) {
+	return index & (Dis68kOperand::IndexAddressRegister | 7);
+}
+
+/* @returns Whether the last operand of @c inst, usually its destination, is data register @c reg. */
+bool names_data_register(const Dis68kInstruction &inst, unsigned int reg) {
+	if (!inst.operand_count) return false;
+	const Dis68kOperand &destination = inst.operands[inst.operand_count - 1];
+	return destination.mode == ModeDataRegister && destination.reg == reg;
+}
+
+bool ends_block(uint8_t flow) {
+	return flow == FlowBranch || flow == FlowJump || flow == FlowReturn;
+}
+
+bool falls_through(uint8_t flow) {
+	return flow != FlowJump && flow != FlowReturn;
+}
+
+class Scanner {
+public:
+	Scanner(const uint8_t *_begin, const uint8_t *_end, uint32_t _address, const std::vector<uint32_t> &_known) :
+		begin(_begin), end(_end), address(_address), size(uint32_t(_end - _begin)), known(_known) {}
+
+	bool inside(uint32_t a) const {
+		return a - address < size;
+	}
+
+	/* Decodes the function at scan.entry into scan; visited must be clear on entry and is left clear. */
+	void scan(Scan &scan, std::vector<uint64_t> &visited) const;
+
+private:
+	bool tail_call(const Scan &scan, uint32_t target) const {
+		return target != scan.entry && std::binary_search(known.begin(), known.end(), target);
+	}
+
+	bool recover_table(const Dis68kInstruction *window, unsigned int count, JumpTable &table, std::vector<uint32_t> &cases) const;
+	unsigned int guard_bound(const Dis68kInstruction *window, unsigned int count, unsigned int reg) const;
+
+	void build_blocks(Scan &scan, std::vector<Step> &steps, std::vector<uint32_t> &leaders) const;
+	void track_registers(Scan &scan) const;
+
+	const uint8_t *begin, *end;
+	uint32_t address, size;
+	const std::vector<uint32_t> &known;		// every function entry found so far, sorted
+};
+
+void Scanner::scan(Scan &scan, std::vector<uint64_t> &visited) const {
+	Dis68k dis(begin, end, address);
+	Dis68kInstruction window[dispatch_window];
+
+	std::vector<Step> steps;
+	std::vector<uint32_t> pending(1, scan.entry), leaders(1, scan.entry), marked;
+	scan.clean = true;
+	scan.returns = false;
+
+	while (!pending.empty()) {
+		uint32_t a = pending.back();
+		pending.pop_back();
+		unsigned int run = 0;
+
+		/* Follow straight-line code until it leaves, or rejoins code already seen. */
+		while (inside(a) && !(a & 1)) {
+			const uint32_t word = (a - address) >> 1;
+			uint64_t &bits = visited[word >> 6];
+			if (bits & (uint64_t(1) << (word & 63))) break;
+			bits |= uint64_t(1) << (word & 63);
+			marked.push_back(word);
+
+			/* The window holds the last few instructions of this straight-line run, oldest first. */
+			if (run == dispatch_window) {
+				std::copy(window + 1, window + dispatch_window, window);
+				--run;
+			}
+			Dis68kInstruction &inst = window[run];
+			dis.seek(a);
+			if (!dis.decode(inst) || dis.overflowed()) {
+				scan.clean = false;
+				break;
+			}
+			++run;
+			steps.push_back(Step{a, inst.target, inst.length, inst.flow, inst.has_target, 0, 0});
+
+			if (inst.opnum == OpJMP && inst.operands[0].mode == ModePCIndexed) {
+				JumpTable table;
+				const size_t first_case = scan.cases.size();
+				if (recover_table(window, run, table, scan.cases)) {
+					steps.back().cases = uint16_t(scan.cases.size() - first_case);
+					steps.back().first_case = uint32_t(first_case);
+					scan.tables.push_back(table);
+					for (size_t c = first_case; c < scan.cases.size(); ++c) {
+						pending.push_back(scan.cases[c]);
+						leaders.push_back(scan.cases[c]);
+					}
+				}
+				break;
+			}
+
+			const bool known_target = inst.has_target && inside(inst.target);
+			if (inst.flow == FlowCall) {
+				if (known_target) scan.callees.push_back(std::make_pair(inst.target, uint8_t(OriginCall)));
+			} else if (inst.flow == FlowBranch || inst.flow == FlowJump) {
+				if (known_target) {
+					if (tail_call(scan, inst.target)) {
+						scan.callees.push_back(std::make_pair(inst.target, uint8_t(OriginTailCall)));
+					} else {
+						pending.push_back(inst.target);
+						leaders.push_back(inst.target);
+					}
+				}
+				if (inst.flow == FlowJump) break;
+			} else if (inst.flow == FlowReturn) {
+				scan.returns = true;
+				break;
+			}
+			a += inst.length;
+		}
+	}
+
+	for (uint32_t word : marked) {
+		visited[word >> 6] &= ~(uint64_t(1) << (word & 63));
+	}
+	build_blocks(scan, steps, leaders);
+	track_registers(scan);
+}
+
+/*
+	Recognises the dispatch ending window[0, count) and appends its cases: either
+	a table of word offsets loaded by MOVE.W d(PC,Xn),Dn and added to the base of
+	JMP d(PC,Dn), or a run of branches that JMP d(PC,Xn) indexes directly.
+*/
+bool Scanner::recover_table(const Dis68kInstruction *window, unsigned int count, JumpTable &table, std::vector<uint32_t> &cases) const {
+	const Dis68kInstruction &jmp = window[count - 1];
+	const Dis68kOperand &dispatch = jmp.operands[0];
+	unsigned int index = index_register(dispatch.index);
+
+	table.dispatch = jmp.address;
+	table.base = dispatch.value;
+	table.function = 0;
+	table.kind = JumpTableBranches;
+	table.table = dispatch.value;
+
+	/* Find the instruction that last set the JMP's index; a load from a PC-relative table makes this an offset table. */
+	unsigned int scanned = count - 1;
+	if (index < 8) {
+		while (scanned && !names_data_register(window[scanned - 1], index)) --scanned;
+		if (scanned) {
+			const Dis68kInstruction &load = window[scanned - 1];
+			if (load.opnum == OpMOVE && load.size == SizeWord && load.operands[0].mode == ModePCIndexed) {
+				table.kind = JumpTableOffsets;
+				table.table = load.operands[0].value;
+				index = index_register(load.operands[0].index);
+				--scanned;
+			} else {
+				scanned = count - 1;
+			}
+		} else {
+			scanned = count - 1;
+		}
+	}
+
+	const unsigned int bound = index < 8 ? guard_bound(window, scanned, index) : 0;
+	const unsigned int limit = bound ? std::min(bound, kMaxJumpTableEntries) : kMaxJumpTableEntries;
+	table.bounded = bound != 0;
+
+	/* Unbounded tables end where their entries stop making sense, or where the first case begins. */
+	uint32_t lowest_case = UINT32_MAX;
+	const size_t first_case = cases.size();
+	unsigned int entries = 0;
+	if (table.kind == JumpTableOffsets) {
+		table.entry_size = 2;
+		for (; entries < limit; ++entries) {
+			const uint32_t entry = table.table + entries * 2;
+			if (!inside(entry) || !inside(entry + 1)) break;
+			if (!bound && entry >= lowest_case) break;
+
+			const uint8_t *const data = begin + (entry - address);
+			const uint32_t target = table.base + uint32_t(int16_t((data[0] << 8) | data[1]));
+			if ((target & 1) || !inside(target)) break;
+			if (target > table.table) lowest_case = std::min(lowest_case, target);
+			cases.push_back(target);
+		}
+	} else {
+		Dis68k dis(begin, end, address);
+		Dis68kInstruction entry;
+		table.entry_size = 0;
+		for (; entries < limit; ++entries) {
+			const uint32_t at = table.table + entries * table.entry_size;
+			if (!bound && at >= lowest_case) break;
+
+			dis.seek(at);
+			if (!dis.decode(entry) || dis.overflowed() || entry.flow != FlowJump) break;
+			if (!table.entry_size) table.entry_size = entry.length;
+			if (entry.length != table.entry_size) break;
+			if (entry.has_target && entry.target > at) lowest_case = std::min(lowest_case, entry.target);
+			cases.push_back(at);
+		}
+	}
+
+	if (!entries) {
+		cases.resize(first_case);
+		return false;
+	}
+	table.count = uint16_t(entries);
+	return true;
+}
+
+/*
+	Looks back through window[0, count) for CMP #n,Dreg or CMPI #n,Dreg followed by
+	a branch away when the index is out of range.
+
+	@returns The number of valid indices, or 0 if there's no such check.
+*/
+unsigned int Scanner::guard_bound(const Dis68kInstruction *window, unsigned int count, unsigned int reg) const {
+	for (unsigned int i = count; i >= 2; --i) {
+		const Dis68kInstruction &branch = window[i - 1];
+		const Dis68kInstruction &compare = window[i - 2];
+		if (branch.opnum != OpBcc || branch.flow != FlowBranch) continue;
+		if (compare.opnum != OpCMP && compare.opnum != OpCMPI) continue;
+		if (compare.operands[0].mode != ModeImmediate || !names_data_register(compare, reg)) continue;
+
+		/* Indices are treated as unsigned whichever way the comparison was made. */
+		const uint32_t limit = compare.operands[0].value;
+		switch (branch.condition) {
+			case ConditionHI:
+			case ConditionGT:
+				return limit < kMaxJumpTableEntries ? limit + 1 : 0;
+			case ConditionCC:
+			case ConditionGE:
+				return limit <= kMaxJumpTableEntries ? limit : 0;
+		}
+		return 0;
+	}
+	return 0;
+}
+
+void Scanner::build_blocks(Scan &scan, std::vector<Step> &steps, std::vector<uint32_t> &leaders) const {
+	std::sort(steps.begin(), steps.end(), [](const Step &a, const Step &b) { return a.address < b.address; });
+	std::sort(leaders.begin(), leaders.end());
+
+	/* A block starts at a leader, after a block-ending instruction, or where code isn't contiguous. */
+	std::vector<uint32_t> last_steps;
+	for (size_t i = 0; i < steps.size(); ++i) {
+		const Step &step = steps[i];
+		const bool starts = !i ||
+			ends_block(steps[i - 1].flow) ||
+			steps[i - 1].address + steps[i - 1].length != step.address ||
+			std::binary_search(leaders.begin(), leaders.end(), step.address);
+		if (starts) {
+			if (i) last_steps.push_back(uint32_t(i - 1));
+			scan.blocks.push_back(BasicBlock{step.address, 0, 0, 0, 0});
+		}
+	}
+	if (!steps.empty()) last_steps.push_back(uint32_t(steps.size() - 1));
+
+	const size_t count = scan.blocks.size();
+	for (size_t b = 0; b < count; ++b) {
+		const Step &last = steps[last_steps[b]];
+		scan.blocks[b].end = last.address + last.length;
+		scan.blocks[b].last = last.address;
+		scan.blocks[b].flow = last.flow;
+	}
+
+	const auto find_block = [&](uint32_t start) -> long {
+		const auto found = std::lower_bound(scan.blocks.begin(), scan.blocks.end(), start,
+			[](const BasicBlock &block, uint32_t a) { return block.start < a; });
+		if (found == scan.blocks.end() || found->start != start) return -1;
+		return long(found - scan.blocks.begin());
+	};
+
+	/* The entry block goes first; the others keep address order. */
+	const long entry_block = find_block(scan.entry);
+	std::vector<uint32_t> order(count);
+	for (size_t b = 0; b < count; ++b) {
+		order[b] = uint32_t(long(b) < entry_block ? b + 1 : b);
+	}
+	if (entry_block >= 0) order[entry_block] = 0;
+
+	std::vector<uint32_t> successors_by_address;
+	std::vector<uint32_t> offsets(count + 1, 0);
+	for (size_t b = 0; b < count; ++b) {
+		const BasicBlock &block = scan.blocks[b];
+		const Step &last = steps[last_steps[b]];
+		offsets[b] = uint32_t(successors_by_address.size());
+
+		if (falls_through(last.flow) && b + 1 < count && scan.blocks[b + 1].start == block.end) {
+			successors_by_address.push_back(order[b + 1]);
+		}
+		if ((last.flow == FlowBranch || last.flow == FlowJump) && last.has_target &&
+			inside(last.target) && !tail_call(scan, last.target)) {
+			const long target = find_block(last.target);
+			if (target >= 0) successors_by_address.push_back(order[target]);
+		}
+		for (uint32_t c = last.first_case; c < last.first_case + last.cases; ++c) {
+			const long target = find_block(scan.cases[c]);
+			if (target >= 0) successors_by_address.push_back(order[target]);
+		}
+
+		const auto first = successors_by_address.begin() + offsets[b];
+		std::sort(first, successors_by_address.end());
+		successors_by_address.erase(std::unique(first, successors_by_address.end()), successors_by_address.end());
+	}
+	offsets[count] = uint32_t(successors_by_address.size());
+
+	std::vector<BasicBlock> blocks(count);
+	scan.successor_offsets.assign(count + 1, 0);
+	for (size_t b = 0; b < count; ++b) {
+		blocks[order[b]] = scan.blocks[b];
+		scan.successor_offsets[order[b] + 1] = offsets[b + 1] - offsets[b];
+	}
+	for (size_t b = 0; b < count; ++b) {
+		scan.successor_offsets[b + 1] += scan.successor_offsets[b];
+	}
+	scan.successors.resize(successors_by_address.size());
+	for (size_t b = 0; b < count; ++b) {
+		std::copy(successors_by_address.begin() + offsets[b], successors_by_address.begin() + offsets[b + 1],
+			scan.successors.begin() + scan.successor_offsets[order[b]]);
+	}
+	scan.blocks.swap(blocks);
+}
+
+/*
+	Runs through the blocks of scan once, in order, tracking register constants.
+	A block starts from what its predecessors agree on if all of them have
+	already been through, and from nothing otherwise.
+*/
+void Scanner::track_registers(Scan &scan) const {
+	const size_t count = scan.blocks.size();
+	std::vector<RegisterState> exits(count);
+
+	/* Predecessors, in CSR form like the successors, noting those that come later in the pass. */
+	std::vector<uint32_t> predecessor_offsets(count + 1, 0), predecessors(scan.successors.size()), unfinished(count, 0);
+	for (size_t b = 0; b < count; ++b) {
+		for (uint32_t s = scan.successor_offsets[b]; s < scan.successor_offsets[b + 1]; ++s) {
+			const uint32_t successor = scan.successors[s];
+			++predecessor_offsets[successor + 1];
+			if (successor <= b) ++unfinished[successor];
+		}
+	}
+	for (size_t b = 0; b < count; ++b) predecessor_offsets[b + 1] += predecessor_offsets[b];
+	{
+		std::vector<uint32_t> fill(predecessor_offsets.begin(), predecessor_offsets.end() - 1);
+		for (size_t b = 0; b < count; ++b) {
+			for (uint32_t s = scan.successor_offsets[b]; s < scan.successor_offsets[b + 1]; ++s) {
+				predecessors[fill[scan.successors[s]]++] = uint32_t(b);
+			}
+		}
+	}
+
+	Dis68k dis(begin, end, address);
+	Dis68kInstruction inst;
+	for (size_t b = 0; b < count; ++b) {
+		RegisterState state;
+		if (predecessor_offsets[b] != predecessor_offsets[b + 1] && !unfinished[b]) {
+			state = exits[predecessors[predecessor_offsets[b]]];
+			for (uint32_t p = predecessor_offsets[b] + 1; p < predecessor_offsets[b + 1]; ++p) {
+				state.meet(exits[predecessors[p]]);
+			}
+		}
+
+		const BasicBlock &block = scan.blocks[b];
+		for (uint32_t a = block.start; a < block.end; a = dis.tell()) {
+			dis.seek(a);
+			if (!dis.decode(inst)) break;
+
+			/* Only operands that go through a register need resolving. */
+			for (unsigned int k = 0; k < inst.operand_count; ++k) {
+				const Dis68kOperand &op = inst.operands[k];
+				if (op.mode < ModeIndirect || op.mode > ModeIndexed) continue;
+
+				uint32_t target;
+				if (!effective_address(state, op, inst.size, target)) continue;
+
+				uint8_t kind = ReferenceData;
+				if (inst.opnum == OpJSR || inst.opnum == OpJMP) {
+					kind = inst.opnum == OpJSR ? ReferenceCall : ReferenceJump;
+					if (inside(target) && !(target & 1)) {
+						scan.callees.push_back(std::make_pair(target, uint8_t(OriginRegister | (kind == ReferenceCall ? OriginCall : OriginTailCall))));
+					}
+				}
+				scan.references.push_back(Reference{inst.address, target, uint8_t(k), kind});
+			}
+			track_instruction(state, inst);
+		}
+		exits[b] = state;
+	}
+}
+
+/* Appends the even addresses in [begin, end) that hold LINK and weren't reached by any scan. */
+void find_prologues(const uint8_t *begin, const uint8_t *end, uint32_t address, const std::vector<Scan> &scans, std::vector<uint32_t> &prologues) {
+	const uint32_t size = uint32_t(end - begin);
+	std::vector<bool> covered(size, false);
+	for (const Scan &scan : scans) {
+		for (const BasicBlock &block : scan.blocks) {
+			const uint32_t from = block.start - address, to = std::min(size, block.end - address);
+			std::fill(covered.begin() + from, covered.begin() + to, true);
+		}
+		for (const JumpTable &table : scan.tables) {
+			if (table.kind != JumpTableOffsets) continue;
+			const uint32_t from = table.table - address, to = std::min(size, from + table.count * 2u);
+			std::fill(covered.begin() + from, covered.begin() + to, true);
+		}
+	}
+
+	for (uint32_t offset = 0; offset + 1 < size; offset += 2) {
+		if (covered[offset]) continue;
+		if (begin[offset] == 0x4e && (begin[offset + 1] & 0xf8) == 0x50) {
+			prologues.push_back(address + offset);
+		}
+	}
+}
+
+}
+
+long Program::find_function(uint32_t address) const {
+	const auto found = std::lower_bound(functions.begin(), functions.end(), address,
+		[](const Function &function, uint32_t a) { return function.entry < a; });
+	if (found == functions.end() || found->entry != address) return -1;
+	return long(found - functions.begin());
+}
+
+bool analyse_program(const void *begin, const void *end, uint32_t address, const std::vector<uint32_t> &entry_points, Program &program, unsigned int threads) {
+	const uint8_t *const data = (const uint8_t *)begin;
+	const uint8_t *const data_end = (const uint8_t *)end;
+	const uint32_t size = uint32_t(data_end - data);
+	const unsigned int workers = worker_count(threads);
+
+	std::vector<uint32_t> known;
+	std::vector<Scan> scans;
+	std::unordered_map<uint32_t, uint32_t> scan_index;
+	const Scanner scanner(data, data_end, address, known);
+
+	std::vector<std::pair<uint32_t, uint8_t>> round;
+	for (uint32_t entry : entry_points) {
+		if (scanner.inside(entry) && !(entry & 1)) round.push_back(std::make_pair(entry, uint8_t(OriginEntryPoint)));
+	}
+	if (round.empty()) {
+		fprintf(stderr, "analyse_program: no entry point lies within $%08x-$%08x\n", address, address + size);
+		return false;
+	}
+
+	const auto add = [&](std::vector<std::pair<uint32_t, uint8_t>> &next, uint32_t entry, uint8_t origin) {
+		const auto found = scan_index.find(entry);
+		if (found != scan_index.end()) {
+			if (found->second < scans.size()) {
+				scans[found->second].origin |= origin;
+			} else {
+				next[found->second - scans.size()].second |= origin;
+			}
+			return;
+		}
+		scan_index[entry] = uint32_t(scans.size() + next.size());
+		next.push_back(std::make_pair(entry, origin));
+	};
+	{
+		std::vector<std::pair<uint32_t, uint8_t>> seeds;
+		for (const auto &entry : round) add(seeds, entry.first, entry.second);
+		round.swap(seeds);
+	}
+
+	/* Each round decodes the functions found by the last, in parallel; every entry is known before its round starts. */
+	bool prologues_scanned = false;
+	while (!round.empty()) {
+		const size_t first = scans.size();
+		scans.resize(first + round.size());
+		for (size_t k = 0; k < round.size(); ++k) {
+			scans[first + k].entry = round[k].first;
+			scans[first + k].origin = round[k].second;
+			known.push_back(round[k].first);
+		}
+		std::sort(known.begin(), known.end());
+
+		parallel_for(round.size(), workers, [&](size_t k) {
+			thread_local std::vector<uint64_t> visited;
+			const size_t words = (size_t(size) / 2 + 63) / 64;
+			if (visited.size() < words) visited.resize(words, 0);
+			scanner.scan(scans[first + k], visited);
+		});
+
+		std::vector<std::pair<uint32_t, uint8_t>> next;
+		for (size_t k = first; k < scans.size(); ++k) {
+			if (spurious(scans[k])) continue;
+			for (const auto &callee : scans[k].callees) {
+				if (!(callee.first & 1)) add(next, callee.first, callee.second);
+			}
+		}
+
+		if (next.empty() && !prologues_scanned) {
+			std::vector<uint32_t> prologues;
+			find_prologues(data, data_end, address, scans, prologues);
+			for (uint32_t entry : prologues) add(next, entry, OriginPrologue);
+			prologues_scanned = true;
+		}
+		round.swap(next);
+	}
+
+	/* Gather the surviving functions in entry order. */
+	std::vector<uint32_t> kept;
+	for (uint32_t k = 0; k < scans.size(); ++k) {
+		if (spurious(scans[k])) continue;
+		kept.push_back(k);
+	}
+	std::sort(kept.begin(), kept.end(), [&](uint32_t a, uint32_t b) { return scans[a].entry < scans[b].entry; });
+
+	const size_t function_count = kept.size();
+	program.functions.resize(function_count);
+	program.jump_tables.clear();
+	program.references.clear();
+	uint32_t block_count = 0;
+	for (size_t f = 0; f < function_count; ++f) {
+		const Scan &scan = scans[kept[f]];
+		program.functions[f] = Function{scan.entry, block_count, uint32_t(scan.blocks.size()), scan.origin, scan.returns};
+		block_count += uint32_t(scan.blocks.size());
+
+		for (JumpTable table : scan.tables) {
+			table.function = uint32_t(f);
+			program.jump_tables.push_back(table);
+		}
+		program.references.insert(program.references.end(), scan.references.begin(), scan.references.end());
+	}
+
+	/* A block shared by two functions was tracked in both. */
+	const auto reference_order = [](const Reference &a, const Reference &b) {
+		return a.instruction < b.instruction || (a.instruction == b.instruction && a.operand < b.operand) ||
+			(a.instruction == b.instruction && a.operand == b.operand && a.target < b.target);
+	};
+	std::sort(program.references.begin(), program.references.end(), reference_order);
+	program.references.erase(std::unique(program.references.begin(), program.references.end(),
+		[](const Reference &a, const Reference &b) { return a.instruction == b.instruction && a.operand == b.operand && a.target == b.target; }),
+		program.references.end());
+	std::sort(program.jump_tables.begin(), program.jump_tables.end(),
+		[](const JumpTable &a, const JumpTable &b) { return a.dispatch < b.dispatch || (a.dispatch == b.dispatch && a.function < b.function); });
+
+	/* Block successors, and callees as function indices. */
+	program.blocks.resize(block_count);
+	program.cfg.offsets.assign(size_t(block_count) + 1, 0);
+	program.calls.offsets.assign(function_count + 1, 0);
+	std::vector<std::vector<uint32_t>> callees(function_count);
+	parallel_for(function_count, workers, [&](size_t f) {
+		const Scan &scan = scans[kept[f]];
+		const Function &function = program.functions[f];
+		for (uint32_t b = 0; b < function.block_count; ++b) {
+			BasicBlock &block = program.blocks[function.first_block + b];
+			block = scan.blocks[b];
+			block.function = uint32_t(f);
+			program.cfg.offsets[function.first_block + b + 1] = scan.successor_offsets[b + 1] - scan.successor_offsets[b];
+		}
+
+		for (const auto &callee : scan.callees) {
+			const long index = program.find_function(callee.first);
+			if (index >= 0) callees[f].push_back(uint32_t(index));
+		}
+		std::sort(callees[f].begin(), callees[f].end());
+		callees[f].erase(std::unique(callees[f].begin(), callees[f].end()), callees[f].end());
+		program.calls.offsets[f + 1] = uint32_t(callees[f].size());
+	});
+
+	for (size_t b = 0; b < block_count; ++b) program.cfg.offsets[b + 1] += program.cfg.offsets[b];
+	for (size_t f = 0; f < function_count; ++f) program.calls.offsets[f + 1] += program.calls.offsets[f];
+	program.cfg.edges.resize(program.cfg.offsets[block_count]);
+	program.calls.edges.resize(program.calls.offsets[function_count]);
+
+	parallel_for(function_count, workers, [&](size_t f) {
+		const Scan &scan = scans[kept[f]];
+		const Function &function = program.functions[f];
+		for (uint32_t b = 0; b < function.block_count; ++b) {
+			uint32_t *const out = program.cfg.edges.data() + program.cfg.offsets[function.first_block + b];
+			uint32_t *out_end = out;
+			for (uint32_t s = scan.successor_offsets[b]; s < scan.successor_offsets[b + 1]; ++s) {
+				*out_end++ = function.first_block + scan.successors[s];
+			}
+			std::sort(out, out_end);
+		}
+		std::copy(callees[f].begin(), callees[f].end(), program.calls.edges.begin() + program.calls.offsets[f]);
+	});
+	return true;
+}
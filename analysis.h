@@ -0,0 +1,119 @@
+#if !defined( ANALYSIS_H )
+#define ANALYSIS_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+/*!
+	A directed graph over nodes 0 to n - 1 in compressed sparse row form: the
+	successors of node @c i are @c edges[offsets[i]] to @c edges[offsets[i + 1] - 1],
+	in ascending order.
+*/
+struct CsrGraph {
+	std::vector<uint32_t> offsets;	// node count + 1 entries
+	std::vector<uint32_t> edges;
+
+	size_t node_count() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	const uint32_t *begin(uint32_t node) const { return edges.data() + offsets[node]; }
+	const uint32_t *end(uint32_t node) const { return edges.data() + offsets[node + 1]; }
+	uint32_t degree(uint32_t node) const { return offsets[node + 1] - offsets[node]; }
+};
+
+/// A run of instructions entered only at its start and left only at its end.
+struct BasicBlock {
+	uint32_t start, end;		// addresses; end is just past the last instruction
+	uint32_t function;			// index of the owning function
+	uint32_t last;				// address of the last instruction
+	uint8_t flow;				// the Flow of the last instruction
+};
+
+/// How a function was found.
+enum FunctionOrigin {
+	OriginEntryPoint = 0x01,	// one of the entry points given to analyse_program
+	OriginCall = 0x02,			// target of a BSR or JSR
+	OriginTailCall = 0x04,		// target of a BRA or JMP from another function
+	OriginPrologue = 0x08,		// a LINK found in otherwise unreached code
+	OriginRegister = 0x10		// target of a JSR or JMP through a register of known value
+};
+
+enum JumpTableKind {
+	JumpTableOffsets,		// MOVE.W d(PC,Xn),Dn; JMP d(PC,Dn): words giving each case relative to the JMP's base
+	JumpTableBranches		// JMP d(PC,Xn) into a run of equal-length BRA or JMP instructions
+};
+
+/// A recovered switch dispatch.
+struct JumpTable {
+	uint32_t dispatch;		// address of the JMP
+	uint32_t table;			// address of the first entry
+	uint32_t base;			// the JMP's PC-relative base; offsets are added to this
+	uint32_t function;		// index of the owning function
+	uint16_t count;			// entries
+	uint8_t entry_size;		// bytes per entry
+	uint8_t kind;			// a JumpTableKind
+	bool bounded;			// count comes from a CMP and Bcc guarding the index, rather than from the entries themselves
+};
+
+/// The most entries taken from a jump table with no bounds check in front of it.
+const unsigned int kMaxJumpTableEntries = 1024;
+
+enum ReferenceKind {
+	ReferenceData,		// a memory operand, or the address LEA computes
+	ReferenceCall,		// JSR through a register
+	ReferenceJump		// JMP through a register
+};
+
+/// An address that an instruction uses through a register holding a known constant.
+struct Reference {
+	uint32_t instruction;	// address of the instruction
+	uint32_t target;
+	uint8_t operand;		// index into Dis68kInstruction::operands
+	uint8_t kind;			// a ReferenceKind
+};
+
+struct Function {
+	uint32_t entry;
+	uint32_t first_block, block_count;	// into Program::blocks; the entry block is first
+	uint8_t origin;						// FunctionOrigin flags
+	bool returns;						// some block ends in RTS, RTE or RTR
+};
+
+/*!
+	The functions of an image, their basic blocks, and the graphs between them.
+	Functions are in ascending order of entry; each function's blocks are
+	contiguous, with the entry block first and the rest in address order; an
+	entry point that doesn't decode gives a function with no blocks. A block
+	reached from two functions belongs to both, as two blocks.
+*/
+struct Program {
+	std::vector<Function> functions;
+	std::vector<BasicBlock> blocks;
+	CsrGraph cfg;		// block to successor blocks, within a function
+	CsrGraph calls;		// function to the functions it calls or tail-calls
+	std::vector<JumpTable> jump_tables;	// in ascending order of dispatch
+	std::vector<Reference> references;	// in ascending order of instruction, then operand
+
+	/// @returns The index of the function with entry @c address, or -1.
+	long find_function(uint32_t address) const;
+};
+
+/*!
+	Finds the functions of the image [@c begin, @c end), located at @c address,
+	by recursive descent from @c entry_points: the targets of BSR and of JSR to
+	known addresses become functions, and control flow is followed through
+	branches and jumps to returns. Jump tables behind @c JMP d(PC,Xn) are
+	decoded, and their cases followed as successors of the JMP. A forward pass
+	over each function's blocks tracks registers loaded with constants, giving
+	Program::references and making the targets of JSR (An) and the like into
+	further functions; see registers.h. Unreached code is then scanned for LINK
+	prologues, which are kept as functions if they decode cleanly to a return.
+
+	Once a round of entries is known, functions are decoded and split into
+	blocks in parallel, on @c threads threads or one per hardware thread if zero.
+
+	@returns @c false, having printed a diagnostic, if no entry point is inside the image.
+*/
+bool analyse_program(const void *begin, const void *end, uint32_t address, const std::vector<uint32_t> &entry_points, Program &program, unsigned int threads = 0);
+
+#endif // ANALYSIS_H
@@ -0,0 +1,377 @@
+/*	68000 instruction timing; see cycles.h. */
+
+#include <algorithm>
+#include <utility>
+
+#include "cycles.h"
+#include "listing.h"
+#include "parallel.h"
+
+namespace {
+
+/* Effective address calculation, by mode, for byte or word and for long operands. */
+const uint8_t ea_cycles[2][12] = {
+	{0, 0, 4, 4, 6,  8, 10,  8, 12,  8, 10, 4},
+	{0, 0, 8, 8, 10, 12, 14, 12, 16, 12, 14, 8}
+};
+
+/* MOVE destination cost, by mode; -(An) costs the same as (An) here. */
+const uint8_t move_destination_cycles[2][9] = {
+	{0, 0, 4, 4, 4,  8, 10,  8, 12},
+	{0, 0, 8, 8, 8, 12, 14, 12, 16}
+};
+
+/* Control addressing modes, by mode; zero where a mode isn't allowed. */
+const uint8_t jmp_cycles[12] = {0, 0, 8,  0, 0, 10, 14, 10, 12, 10, 14, 0};
+const uint8_t jsr_cycles[12] = {0, 0, 16, 0, 0, 18, 22, 18, 20, 18, 22, 0};
+const uint8_t lea_cycles[12] = {0, 0, 4,  0, 0,  8, 12,  8, 12,  8, 12, 0};
+const uint8_t pea_cycles[12] = {0, 0, 12, 0, 0, 16, 20, 16, 20, 16, 20, 0};
+
+/* MOVEM, before 4 or 8 per register. */
+const uint8_t movem_load_cycles[12] = {0, 0, 12, 12, 0, 16, 18, 16, 20, 16, 18, 0};
+const uint8_t movem_store_cycles[12] = {0, 0, 8,  0,  8, 12, 14, 12, 16,  0,  0, 0};
+
+bool is_long(const Dis68kInstruction &inst) {
+	return inst.size == SizeLong;
+}
+
+unsigned int ea(const Dis68kInstruction &inst, int index) {
+	const unsigned int mode = inst.operands[index].mode;
+	return mode < 12 ? ea_cycles[is_long(inst)][mode] : 0;
+}
+
+bool in_register(const Dis68kOperand &op) {
+	return op.mode == ModeDataRegister || op.mode == ModeAddressRegister;
+}
+
+/* Register or memory forms of a one-operand instruction, or of one whose last operand is the destination. */
+unsigned int destination(const Dis68kInstruction &inst, unsigned int reg_bw, unsigned int reg_l, unsigned int mem_bw, unsigned int mem_l) {
+	const int last = inst.operand_count - 1;
+	if (in_register(inst.operands[last])) return is_long(inst) ? reg_l : reg_bw;
+	return (is_long(inst) ? mem_l : mem_bw) + ea(inst, last);
+}
+
+unsigned int count_bits(uint32_t value) {
+	unsigned int count = 0;
+	for (; value; value &= value - 1) ++count;
+	return count;
+}
+
+}
+
+bool instruction_cycles(const Dis68kInstruction &inst, InstructionCycles &timing) {
+	unsigned int cycles = 0, taken = 0;
+	bool variable = false;
+	const Dis68kOperand *const ops = inst.operands;
+
+	switch (inst.opnum) {
+		case OpABCD: case OpSBCD:
+			cycles = ops[0].mode == ModeDataRegister ? 6 : 18;
+			break;
+
+		case OpADD: case OpSUB: case OpAND: case OpOR:
+		case OpCMP:
+			if (ops[1].mode == ModeDataRegister) {
+				/* Long operations from a register or immediate take two more. */
+				cycles = (is_long(inst) ? ((in_register(ops[0]) || ops[0].mode == ModeImmediate) && inst.opnum != OpCMP ? 8 : 6) : 4) + ea(inst, 0);
+			} else {
+				cycles = (is_long(inst) ? 12 : 8) + ea(inst, 1);
+			}
+			break;
+
+		case OpEOR:
+			cycles = destination(inst, 4, 8, 8, 12);
+			break;
+
+		case OpADDA: case OpSUBA:
+			cycles = (is_long(inst) ? ((in_register(ops[0]) || ops[0].mode == ModeImmediate) ? 8 : 6) : 8) + ea(inst, 0);
+			break;
+
+		case OpCMPA:
+			cycles = 6 + ea(inst, 0);
+			break;
+
+		case OpADDI: case OpSUBI: case OpANDI: case OpORI: case OpEORI:
+			if (ops[1].mode == ModeConditionCodes || ops[1].mode == ModeStatusRegister) {
+				cycles = 20;
+			} else {
+				/* ANDI.L to a data register takes two fewer than the rest. */
+				cycles = destination(inst, 8, inst.opnum == OpANDI ? 14 : 16, 12, 20);
+			}
+			break;
+
+		case OpCMPI:
+			cycles = destination(inst, 8, 14, 8, 12);
+			break;
+
+		case OpADDQ: case OpSUBQ:
+			cycles = ops[1].mode == ModeAddressRegister ? 8 : destination(inst, 4, 8, 8, 12);
+			break;
+
+		case OpADDX: case OpSUBX:
+			cycles = ops[0].mode == ModeDataRegister ? (is_long(inst) ? 8 : 4) : (is_long(inst) ? 30 : 18);
+			break;
+
+		case OpCMPM:
+			cycles = is_long(inst) ? 20 : 12;
+			break;
+
+		case OpASL: case OpASR: case OpLSL: case OpLSR:
+		case OpROL: case OpROR: case OpROXL: case OpROXR: {
+			/* Two per bit shifted; a count in a register is taken modulo 64. */
+			unsigned int count = 63;
+			if (ops[0].mode == ModeQuick) {
+				count = ops[0].value;
+			} else {
+				variable = true;
+			}
+			cycles = (is_long(inst) ? 8 : 6) + 2 * count;
+		} break;
+
+		case OpASLMemory: case OpASRMemory: case OpLSLMemory: case OpLSRMemory:
+		case OpROLMemory: case OpRORMemory: case OpROXLMemory: case OpROXRMemory:
+			cycles = 8 + ea(inst, 0);
+			break;
+
+		case OpBcc:
+			if (inst.condition == 0) {
+				cycles = 10;				// BRA
+			} else if (inst.condition == 1) {
+				cycles = 18;				// BSR
+			} else {
+				taken = 10;
+				cycles = inst.size == SizeByte ? 8 : 12;
+			}
+			break;
+
+		case OpDBcc:
+			/* DBT never branches; otherwise looping costs 10 and expiring 14. */
+			if (inst.condition == 0) {
+				cycles = 12;
+			} else {
+				taken = 10;
+				cycles = 14;
+			}
+			break;
+
+		case OpBCHGRegister: case OpBSETRegister:
+			cycles = destination(inst, 8, 8, 8, 8);
+			break;
+		case OpBCLRRegister:
+			cycles = destination(inst, 10, 10, 8, 8);
+			break;
+		case OpBTSTRegister:
+			cycles = destination(inst, 6, 6, 4, 4);
+			break;
+		case OpBCHGImmediate: case OpBSETImmediate:
+			cycles = destination(inst, 12, 12, 12, 12);
+			break;
+		case OpBCLRImmediate:
+			cycles = destination(inst, 14, 14, 12, 12);
+			break;
+		case OpBTSTImmediate:
+			cycles = destination(inst, 10, 10, 8, 8);
+			break;
+
+		case OpCHK:
+			cycles = 10 + ea(inst, 0);
+			break;
+
+		case OpCLR: case OpNEG: case OpNEGX: case OpNOT:
+			cycles = destination(inst, 4, 6, 8, 12);
+			break;
+
+		case OpNBCD:
+			cycles = destination(inst, 6, 6, 8, 8);
+			break;
+
+		case OpScc:
+			/* 4 if the condition is false, 6 if true. */
+			variable = ops[0].mode == ModeDataRegister;
+			cycles = destination(inst, 6, 6, 8, 8);
+			break;
+
+		case OpTAS:
+			cycles = destination(inst, 4, 4, 14, 14);
+			break;
+
+		case OpTST:
+			cycles = 4 + ea(inst, 0);
+			break;
+
+		case OpDIVS:
+			variable = true;
+			cycles = 158 + ea(inst, 0);
+			break;
+		case OpDIVU:
+			variable = true;
+			cycles = 140 + ea(inst, 0);
+			break;
+		case OpMULS: case OpMULU:
+			variable = true;
+			cycles = 70 + ea(inst, 0);
+			break;
+
+		case OpEXG:
+			cycles = 6;
+			break;
+		case OpEXT: case OpSWAP: case OpMOVEQ: case OpMOVEUSP: case OpNOP: case OpSTOP:
+			cycles = 4;
+			break;
+
+		case OpJMP:
+			cycles = jmp_cycles[std::min<unsigned int>(ops[0].mode, 11)];
+			break;
+		case OpJSR:
+			cycles = jsr_cycles[std::min<unsigned int>(ops[0].mode, 11)];
+			break;
+		case OpLEA:
+			cycles = lea_cycles[std::min<unsigned int>(ops[0].mode, 11)];
+			break;
+		case OpPEA:
+			cycles = pea_cycles[std::min<unsigned int>(ops[0].mode, 11)];
+			break;
+
+		case OpLINK:
+			cycles = 16;
+			break;
+		case OpUNLK:
+			cycles = 12;
+			break;
+
+		case OpMOVE:
+		case OpMOVEA: {
+			const unsigned int destination_mode = ops[1].mode;
+			if (destination_mode > ModeAbsoluteLong) return false;
+			cycles = 4 + ea(inst, 0) + move_destination_cycles[is_long(inst)][destination_mode];
+		} break;
+
+		case OpMOVEtoCCR: case OpMOVEtoSR:
+			cycles = 12 + ea(inst, 0);
+			break;
+		case OpMOVEfromSR:
+			cycles = in_register(ops[1]) ? 6 : 8 + ea(inst, 1);
+			break;
+
+		case OpMOVEM: {
+			const bool load = ops[1].mode == ModeRegisterList;
+			const Dis68kOperand &memory = ops[load ? 0 : 1], &list = ops[load ? 1 : 0];
+			if (memory.mode > ModePCIndexed) return false;
+			cycles = (load ? movem_load_cycles : movem_store_cycles)[memory.mode] +
+				(is_long(inst) ? 8 : 4) * count_bits(list.value);
+		} break;
+
+		case OpMOVEP:
+			cycles = is_long(inst) ? 24 : 16;
+			break;
+
+		case OpRESET:
+			cycles = 132;
+			break;
+		case OpRTE: case OpRTR:
+			cycles = 20;
+			break;
+		case OpRTS:
+			cycles = 16;
+			break;
+
+		case OpTRAP:
+			cycles = 34;
+			break;
+		case OpTRAPV:
+			cycles = 4;
+			taken = 34;
+			break;
+
+		default:
+			return false;
+	}
+
+	timing.cycles = uint16_t(cycles);
+	timing.taken = uint16_t(taken ? taken : cycles);
+	timing.variable = variable;
+	return true;
+}
+
+void block_cycles(const void *begin, const void *end, uint32_t address, const Program &program, std::vector<BlockCycles> &cycles, unsigned int threads) {
+	cycles.resize(program.blocks.size());
+
+	/* Blocks are small; hand them out in batches. */
+	const size_t batch = 256;
+	parallel_for((program.blocks.size() + batch - 1) / batch, threads, [&](size_t k) {
+		Dis68k dis(begin, end, address);
+		Dis68kInstruction inst;
+		InstructionCycles timing;
+
+		const size_t last = std::min(program.blocks.size(), (k + 1) * batch);
+		for (size_t b = k * batch; b < last; ++b) {
+			const BasicBlock &block = program.blocks[b];
+			BlockCycles total = {0, 0, false};
+
+			dis.seek(block.start);
+			while (dis.tell() < block.end && dis.decode(inst)) {
+				if (!instruction_cycles(inst, timing)) continue;
+				if (inst.address == block.last) {
+					total.taken = total.cycles + timing.taken;
+				}
+				total.cycles += timing.cycles;
+				total.variable |= timing.variable;
+			}
+			cycles[b] = total;
+		}
+	});
+}
+
+namespace {
+
+/* Appends timings for write_annotated_listing. */
+class TimingAnnotator {
+public:
+	TimingAnnotator(const Program *_program, const std::vector<BlockCycles> &_totals, const std::vector<std::pair<uint32_t, uint32_t>> &_block_ends) :
+		program(_program), totals(_totals), block_ends(_block_ends) {}
+
+	size_t comment(const Dis68kInstruction &inst, char *comment_s, size_t comment_sz) const {
+		InstructionCycles timing;
+		if (!instruction_cycles(inst, timing)) return 0;
+		if (timing.taken != timing.cycles) {
+			return snprintf(comment_s, comment_sz, "%u/%u%s", timing.taken, timing.cycles, timing.variable ? "*" : "");
+		}
+		return snprintf(comment_s, comment_sz, "%u%s", timing.cycles, timing.variable ? "*" : "");
+	}
+
+	/* A block in two functions is listed once. */
+	template<typename Syntax>
+	bool after(const Dis68kInstruction &inst, FILE *out) const {
+		const auto found = std::lower_bound(block_ends.begin(), block_ends.end(), std::make_pair(inst.address, uint32_t(0)));
+		if (found == block_ends.end() || found->first != inst.address) return true;
+
+		const BlockCycles &total = totals[found->second];
+		const uint32_t start = program->blocks[found->second].start;
+		if (total.taken != total.cycles) {
+			return fprintf(out, "\t\t%s block %s%08x: %u/%u%s\n", Syntax::comment, Syntax::hex, start, total.taken, total.cycles, total.variable ? "*" : "") >= 0;
+		}
+		return fprintf(out, "\t\t%s block %s%08x: %u%s\n", Syntax::comment, Syntax::hex, start, total.cycles, total.variable ? "*" : "") >= 0;
+	}
+
+private:
+	const Program *program;
+	const std::vector<BlockCycles> &totals;
+	const std::vector<std::pair<uint32_t, uint32_t>> &block_ends;	// last instruction and block, sorted
+};
+
+}
+
+bool write_timed_listing(const void *begin, const void *end, uint32_t address, const Program *program, FILE *out, OutputSyntax syntax) {
+	std::vector<BlockCycles> totals;
+	std::vector<std::pair<uint32_t, uint32_t>> block_ends;
+	if (program) {
+		block_cycles(begin, end, address, *program, totals);
+		for (uint32_t b = 0; b < program->blocks.size(); ++b) {
+			block_ends.push_back(std::make_pair(program->blocks[b].last, b));
+		}
+		std::sort(block_ends.begin(), block_ends.end());
+	}
+
+	TimingAnnotator annotator(program, totals, block_ends);
+	return write_annotated_listing(begin, end, address, out, syntax, annotator);
+}
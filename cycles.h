@@ -0,0 +1,54 @@
+#if !defined( CYCLES_H )
+#define CYCLES_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "analysis.h"
+#include "dis68k.h"
+
+/*!
+	68000 clock periods for one instruction, as tabulated in the M68000
+	Programmer's Reference Manual, including effective address calculation.
+*/
+struct InstructionCycles {
+	uint16_t cycles;	// when execution continues with the next instruction, or leaves unconditionally
+	uint16_t taken;		// when a Bcc or DBcc branches, or TRAPV traps; otherwise equal to cycles
+	bool variable;		// timing depends on data, e.g. MULU or a shift by Dn; both figures are the worst case
+};
+
+/*!
+	Looks up the timing of @c inst, in constant time.
+
+	@returns @c false if @c inst is not an instruction the tables cover.
+*/
+bool instruction_cycles(const Dis68kInstruction &inst, InstructionCycles &timing);
+
+struct BlockCycles {
+	uint32_t cycles;	// through the block, leaving by its last instruction's fall through or unconditional exit
+	uint32_t taken;		// through the block, leaving by its last instruction's branch
+	bool variable;		// some instruction's timing depends on data
+};
+
+/*!
+	Sums instruction_cycles over every block of @c program, which was analysed
+	from the image [@c begin, @c end) located at @c address, filling @c cycles
+	in block order. Blocks are timed in parallel on @c threads threads, or one
+	per hardware thread if zero.
+*/
+void block_cycles(const void *begin, const void *end, uint32_t address, const Program &program, std::vector<BlockCycles> &cycles, unsigned int threads = 0);
+
+/*!
+	Writes the listing of write_listing, with each instruction's timing appended
+	as a comment, "; 12" or "; 10/8" for taken/not taken, marked '*' where it is
+	data dependent. If @c program is given, the total for each of its blocks
+	follows that block's last instruction.
+
+	@returns @c false on a write error.
+*/
+bool write_timed_listing(const void *begin, const void *end, uint32_t address, const Program *program, FILE *out, OutputSyntax syntax = OutputSyntax::Motorola);
+
+#endif // CYCLES_H
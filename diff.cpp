@@ -0,0 +1,216 @@
+/*	Function-level comparison of two images; see diff.h. */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "diff.h"
+#include "fingerprint.h"
+#include "parallel.h"
+
+namespace {
+
+/* Pairs below this share of their distinct blocks aren't the same function. */
+const double min_similarity = 0.5;
+
+/* Block hashes found in more functions than this, such as a lone RTS, say nothing about which function is which. */
+const size_t max_block_sharing = 64;
+
+/* One side of the comparison: block hashes for each function, sorted, and the hash of the whole function. */
+struct Side {
+	std::vector<std::vector<uint64_t>> blocks;	// per function, sorted
+	std::vector<uint64_t> hashes;				// per function, over its blocks in block order
+	std::vector<long> match;					// per function, the other side's function or -1
+};
+
+bool prepare(const DiffImage &image, Program &program, Side &side, unsigned int threads) {
+	if (!analyse_program(image.begin, image.end, image.address, image.entry_points, program, threads)) return false;
+
+	std::vector<uint64_t> hashes;
+	block_hashes(image.begin, image.end, image.address, program, NormaliseDisplacements, hashes, threads);
+
+	const size_t count = program.functions.size();
+	side.blocks.resize(count);
+	side.hashes.resize(count);
+	side.match.assign(count, -1);
+	parallel_for(count, threads, [&](size_t f) {
+		const Function &function = program.functions[f];
+		uint64_t h = function.block_count;
+		for (uint32_t b = function.first_block; b < function.first_block + function.block_count; ++b) {
+			h = hash_combine(h, hashes[b]);
+		}
+		side.hashes[f] = h;
+		side.blocks[f].assign(hashes.begin() + function.first_block, hashes.begin() + function.first_block + function.block_count);
+		std::sort(side.blocks[f].begin(), side.blocks[f].end());
+	});
+	return true;
+}
+
+/* The size of the multiset intersection of two sorted lists. */
+uint32_t shared(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) {
+	uint32_t count = 0;
+	for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+		if (a[i] < b[j]) {
+			++i;
+		} else if (b[j] < a[i]) {
+			++j;
+		} else {
+			++count, ++i, ++j;
+		}
+	}
+	return count;
+}
+
+struct Candidate {
+	uint32_t new_function, old_function;
+	double similarity;
+};
+
+}
+
+bool diff_images(const DiffImage &old_image, const DiffImage &new_image, RomDiff &diff, unsigned int threads) {
+	Side old_side, new_side;
+	if (!prepare(old_image, diff.old_program, old_side, threads)) return false;
+	if (!prepare(new_image, diff.new_program, new_side, threads)) return false;
+
+	const size_t old_count = old_side.hashes.size(), new_count = new_side.hashes.size();
+
+	/* Identical functions, paired in address order where a hash repeats. */
+	std::unordered_map<uint64_t, std::vector<uint32_t>> by_hash;
+	for (uint32_t f = 0; f < old_count; ++f) {
+		if (!old_side.blocks[f].empty()) by_hash[old_side.hashes[f]].push_back(f);
+	}
+	for (auto &entry : by_hash) std::reverse(entry.second.begin(), entry.second.end());
+	for (uint32_t f = 0; f < new_count; ++f) {
+		if (new_side.blocks[f].empty()) continue;
+		const auto found = by_hash.find(new_side.hashes[f]);
+		if (found == by_hash.end() || found->second.empty()) continue;
+
+		const uint32_t old_function = found->second.back();
+		found->second.pop_back();
+		new_side.match[f] = old_function;
+		old_side.match[old_function] = f;
+	}
+
+	/* The rest are paired by the distinct block hashes they share. */
+	std::unordered_map<uint64_t, std::vector<uint32_t>> by_block;
+	std::vector<size_t> old_distinct(old_count, 0);
+	for (uint32_t f = 0; f < old_count; ++f) {
+		if (old_side.match[f] >= 0) continue;
+		const std::vector<uint64_t> &blocks = old_side.blocks[f];
+		for (size_t b = 0; b < blocks.size(); ++b) {
+			if (b && blocks[b] == blocks[b - 1]) continue;
+			by_block[blocks[b]].push_back(f);
+			++old_distinct[f];
+		}
+	}
+
+	std::vector<std::vector<Candidate>> candidates(new_count);
+	parallel_for(new_count, threads, [&](size_t f) {
+		if (new_side.match[f] >= 0) return;
+
+		std::unordered_map<uint32_t, uint32_t> counts;
+		const std::vector<uint64_t> &blocks = new_side.blocks[f];
+		size_t new_distinct = 0;
+		for (size_t b = 0; b < blocks.size(); ++b) {
+			if (b && blocks[b] == blocks[b - 1]) continue;
+			++new_distinct;
+
+			const auto found = by_block.find(blocks[b]);
+			if (found == by_block.end() || found->second.size() > max_block_sharing) continue;
+			for (uint32_t old_function : found->second) ++counts[old_function];
+		}
+
+		for (const auto &count : counts) {
+			const double similarity = double(count.second) / double(std::max(new_distinct, old_distinct[count.first]));
+			if (similarity >= min_similarity) candidates[f].push_back(Candidate{uint32_t(f), count.first, similarity});
+		}
+	});
+
+	std::vector<Candidate> ranked;
+	for (const std::vector<Candidate> &list : candidates) ranked.insert(ranked.end(), list.begin(), list.end());
+	std::sort(ranked.begin(), ranked.end(), [](const Candidate &a, const Candidate &b) {
+		if (a.similarity != b.similarity) return a.similarity > b.similarity;
+		if (a.new_function != b.new_function) return a.new_function < b.new_function;
+		return a.old_function < b.old_function;
+	});
+	for (const Candidate &candidate : ranked) {
+		if (new_side.match[candidate.new_function] >= 0 || old_side.match[candidate.old_function] >= 0) continue;
+		new_side.match[candidate.new_function] = candidate.old_function;
+		old_side.match[candidate.old_function] = candidate.new_function;
+	}
+
+	/* Pair what's left positionally, where the same number of functions lie between the same two matched pairs. */
+	uint32_t previous_old = 0, previous_new = 0;
+	for (uint32_t f = 0; f <= old_count; ++f) {
+		if (f < old_count && old_side.match[f] < 0) continue;
+		const uint32_t next_new = f < old_count ? uint32_t(old_side.match[f]) : uint32_t(new_count);
+		if (next_new < previous_new) continue;		// a function that moved past others
+
+		std::vector<uint32_t> old_gap, new_gap;
+		for (uint32_t g = previous_old; g < f; ++g) {
+			if (old_side.match[g] < 0) old_gap.push_back(g);
+		}
+		for (uint32_t g = previous_new; g < next_new; ++g) {
+			if (new_side.match[g] < 0) new_gap.push_back(g);
+		}
+		if (old_gap.size() == new_gap.size()) {
+			for (size_t k = 0; k < old_gap.size(); ++k) {
+				old_side.match[old_gap[k]] = new_gap[k];
+				new_side.match[new_gap[k]] = old_gap[k];
+			}
+		}
+		previous_old = f + 1;
+		previous_new = next_new + 1;
+	}
+
+	/* Report. */
+	diff.changes.clear();
+	diff.unchanged = diff.changed = diff.added = diff.removed = 0;
+	for (uint32_t f = 0; f < new_count; ++f) {
+		FunctionChange change = {FunctionAdded, 0, diff.new_program.functions[f].entry, 0, uint32_t(new_side.blocks[f].size()), 0};
+		const long match = new_side.match[f];
+		if (match >= 0) {
+			change.old_entry = diff.old_program.functions[match].entry;
+			change.old_blocks = uint32_t(old_side.blocks[match].size());
+			change.shared_blocks = shared(old_side.blocks[match], new_side.blocks[f]);
+			change.kind = old_side.hashes[match] == new_side.hashes[f] ? FunctionUnchanged : FunctionChanged;
+		}
+
+		switch (change.kind) {
+			case FunctionUnchanged: ++diff.unchanged; break;
+			case FunctionChanged: ++diff.changed; break;
+			default: ++diff.added; break;
+		}
+		diff.changes.push_back(change);
+	}
+	for (uint32_t f = 0; f < old_count; ++f) {
+		if (old_side.match[f] >= 0) continue;
+		diff.changes.push_back(FunctionChange{FunctionRemoved, diff.old_program.functions[f].entry, 0, uint32_t(old_side.blocks[f].size()), 0, 0});
+		++diff.removed;
+	}
+	return true;
+}
+
+bool write_diff(const RomDiff &diff, FILE *out, bool all) {
+	for (const FunctionChange &change : diff.changes) {
+		int written = 0;
+		switch (change.kind) {
+			case FunctionUnchanged:
+				if (!all) continue;
+				written = fprintf(out, "  $%08x -> $%08x\tunchanged\n", change.old_entry, change.new_entry);
+				break;
+			case FunctionChanged:
+				written = fprintf(out, "~ $%08x -> $%08x\t%u of %u blocks shared, now %u\n",
+					change.old_entry, change.new_entry, change.shared_blocks, change.old_blocks, change.new_blocks);
+				break;
+			case FunctionAdded:
+				written = fprintf(out, "+ $%08x\t\t%u blocks\n", change.new_entry, change.new_blocks);
+				break;
+			case FunctionRemoved:
+				written = fprintf(out, "- $%08x\t\t%u blocks\n", change.old_entry, change.old_blocks);
+				break;
+		}
+		if (written < 0) return false;
+	}
+	return fprintf(out, "%zu unchanged, %zu changed, %zu added, %zu removed\n", diff.unchanged, diff.changed, diff.added, diff.removed) >= 0;
+}
@@ -0,0 +1,58 @@
+#if !defined( DIFF_H )
+#define DIFF_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "analysis.h"
+
+/// An image to compare, and where to start decoding it.
+struct DiffImage {
+	const void *begin, *end;
+	uint32_t address;
+	std::vector<uint32_t> entry_points;		// e.g. from vector_entry_points
+};
+
+enum FunctionChangeKind {
+	FunctionUnchanged,		// the same code, possibly at a new address
+	FunctionChanged,		// matched, but some blocks differ
+	FunctionAdded,
+	FunctionRemoved
+};
+
+struct FunctionChange {
+	uint8_t kind;					// a FunctionChangeKind
+	uint32_t old_entry, new_entry;	// the absent side of an addition or removal is 0
+	uint32_t old_blocks, new_blocks;
+	uint32_t shared_blocks;			// blocks with the same normalised hash in both
+};
+
+struct RomDiff {
+	Program old_program, new_program;
+	std::vector<FunctionChange> changes;	// in order of new entry, then removals in order of old entry
+	size_t unchanged, changed, added, removed;
+};
+
+/*!
+	Compares the code of two images. Each is analysed into functions and
+	blocks, and every block is hashed with addresses and displacements left
+	out, so that code which has merely moved hashes the same. Functions with
+	identical block hashes are paired first; the rest are paired by the blocks
+	they share, through a table from block hash to function, and then by
+	position, where equal numbers are left between the same two pairs.
+	Whatever is left is an addition or a removal.
+
+	@returns @c false, having printed a diagnostic, if either image can't be analysed.
+*/
+bool diff_images(const DiffImage &old_image, const DiffImage &new_image, RomDiff &diff, unsigned int threads = 0);
+
+/*!
+	Prints the changes of @c diff, one per line, omitting unchanged functions
+	unless @c all is set, and a summary.
+*/
+bool write_diff(const RomDiff &diff, FILE *out, bool all = false);
+
+#endif // DIFF_H
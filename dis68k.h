@@ -2,30 +2,394 @@
 #define DIS68K_H 1
 
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
-class Dis68k
+#include "segments.h"
+#include "views.h"
+
+/*!
+	Output syntax policies for Dis68k::disasm.
+
+	A policy supplies the spellings the decoder composes its text from: the
+	register names, the hex prefix, the data pseudo-ops and the case of
+	mnemonics. All members are compile-time constants, so each dialect is its
+	own fully specialised formatting path with no per-operand branching on the
+	choice of syntax.
+*/
+struct MotorolaSyntax {
+	static constexpr bool lowercase = false;			// lowercase mnemonics
+	static constexpr bool tab_columns = false;			// tab-separated rather than padded columns
+	static constexpr bool pc_comments = true;			// follow d16(PC) operands with their address in braces
+	static constexpr const char *hex = "$";
+	static constexpr const char *data_register = "D";	// followed by the register number
+	static constexpr const char *address_register = "A";
+	static constexpr const char *pc = "PC";
+	static constexpr const char *sr = "SR";
+	static constexpr const char *ccr = "CCR";
+	static constexpr const char *usp = "USP";
+	static constexpr const char *short_suffix = ".W";	// after a name used as xxx.W
+	static constexpr const char *data_word = "DC.W";
+	static constexpr const char *data_byte = "DC.B";
+	static constexpr const char *comment = ";";
+};
+
+/// @c Syntax with lowercase mnemonics and registers.
+template<typename Syntax>
+struct LowercaseSyntax: public Syntax {
+	static constexpr bool lowercase = true;
+	static constexpr const char *data_register = "d";
+	static constexpr const char *address_register = "a";
+	static constexpr const char *pc = "pc";
+	static constexpr const char *sr = "sr";
+	static constexpr const char *ccr = "ccr";
+	static constexpr const char *usp = "usp";
+	static constexpr const char *short_suffix = ".w";
+	static constexpr const char *data_word = "dc.w";
+	static constexpr const char *data_byte = "dc.b";
+};
+
+/// Motorola syntax with lowercase mnemonics and registers.
+struct MotorolaLowerSyntax: public LowercaseSyntax<MotorolaSyntax> {};
+
+/// vasm/Devpac syntax: tab-separated columns, "$" hex.
+struct DevpacSyntax: public MotorolaSyntax {
+	static constexpr bool tab_columns = true;
+};
+
+/// vasm/Devpac syntax with lowercase mnemonics and registers.
+struct DevpacLowerSyntax: public LowercaseSyntax<DevpacSyntax> {};
+
+/// GNU as syntax: lowercase, '%'-prefixed registers, "0x" hex, .short and .byte data, '|' comments.
+struct GnuSyntax: public LowercaseSyntax<DevpacSyntax> {
+	static constexpr bool pc_comments = false;
+	static constexpr const char *hex = "0x";
+	static constexpr const char *data_register = "%d";
+	static constexpr const char *address_register = "%a";
+	static constexpr const char *pc = "%pc";
+	static constexpr const char *sr = "%sr";
+	static constexpr const char *ccr = "%ccr";
+	static constexpr const char *usp = "%usp";
+	static constexpr const char *data_word = ".short";
+	static constexpr const char *data_byte = ".byte";
+	static constexpr const char *comment = "|";
+};
+
+/// Runtime names for the syntax policies above, for selection at startup.
+enum class OutputSyntax {
+	Motorola,
+	MotorolaLower,
+	Devpac,
+	DevpacLower,
+	Gnu
+};
+
+/*!
+	Calls @c f with a default-constructed instance of the policy named by
+	@c syntax, so that a generic lambda can be instantiated once per dialect.
+*/
+template<typename F>
+auto with_syntax(OutputSyntax syntax, F &&f) -> decltype( f(MotorolaSyntax()) )
+{
+	switch( syntax )
+	{
+		default:
+		case OutputSyntax::Motorola:		return f(MotorolaSyntax());
+		case OutputSyntax::MotorolaLower:	return f(MotorolaLowerSyntax());
+		case OutputSyntax::Devpac:			return f(DevpacSyntax());
+		case OutputSyntax::DevpacLower:		return f(DevpacLowerSyntax());
+		case OutputSyntax::Gnu:				return f(GnuSyntax());
+	}
+}
+
+/*!
+	Formats a complete output line from @c opcode_s and @c operand_s, both
+	already in @c Syntax, into its columns. An instruction without operands
+	gets no operand column.
+*/
+template<typename Syntax>
+void format_line(char *out_s, size_t out_sz, const char *opcode_s, const char *operand_s)
+{
+	if( !*operand_s )
+	{
+		snprintf(out_s, out_sz, Syntax::tab_columns ? "\t%s\n" : "%s\n", opcode_s);
+		return;
+	}
+	snprintf(out_s, out_sz, Syntax::tab_columns ? "\t%s\t%s\n" : "%-8s %s\n", opcode_s, operand_s);
+}
+
+/*!
+	Operand kinds. Values 0 to 11 are the effective addressing modes, numbered
+	as by getmode; the rest are the operands that aren't effective addresses.
+*/
+enum OperandMode {
+	ModeDataRegister = 0,	// Dn
+	ModeAddressRegister,	// An
+	ModeIndirect,			// (An)
+	ModePostIncrement,		// (An)+
+	ModePreDecrement,		// -(An)
+	ModeDisplacement,		// d16(An)
+	ModeIndexed,			// d8(An,Xn)
+	ModeAbsoluteShort,		// xxx.W
+	ModeAbsoluteLong,		// xxx.L
+	ModePCDisplacement,		// d16(PC)
+	ModePCIndexed,			// d8(PC,Xn)
+	ModeImmediate,			// #xxx
+	ModeNone,				// getmode's "invalid"
+	ModeQuick,				// data held in the opcode word: ADDQ/SUBQ, MOVEQ, shift counts, TRAP
+	ModeStatusRegister,		// SR
+	ModeConditionCodes,		// CCR
+	ModeUserStackPointer,	// USP
+	ModeRegisterList,		// MOVEM
+	ModeBranchTarget		// Bcc, BSR, DBcc
+};
+
+/*!
+	A decoded operand. @c value holds, by mode: the absolute address for modes 7
+	and 8, sign extended for 7; the PC plus displacement for modes 9 and 10; the
+	data for immediate and quick operands; the register mask, D0 in bit 0 to A7
+	in bit 15, for register lists; and the destination for branch targets.
+*/
+struct Dis68kOperand {
+	enum {
+		IndexAddressRegister = 0x08,	// in index: Xn is An rather than Dn
+		IndexLong = 0x10				// in index: Xn.L rather than Xn.W
+	};
+
+	uint8_t mode;			// an OperandMode
+	uint8_t reg;			// register number for modes 0 to 6
+	uint8_t index;			// index register number and flags for modes 6 and 10
+	int32_t displacement;	// modes 5, 6, 9 and 10
+	uint32_t value;
+};
+
+enum OperandSize {
+	SizeByte = 0,
+	SizeWord,
+	SizeLong,
+	SizeNone
+};
+
+/// How an instruction affects control flow.
+enum Flow {
+	FlowSequential,
+	FlowBranch,		// conditional: Bcc other than BRA and BSR, DBcc
+	FlowJump,		// BRA, JMP
+	FlowCall,		// BSR, JSR
+	FlowReturn,		// RTS, RTE, RTR
+	FlowTrap		// TRAP, TRAPV
+};
+
+/// Indices into the opcode table, as found in Dis68kInstruction::opnum.
+enum Opnum {
+	OpNone = 0,			OpABCD,				OpADD,				OpADDA,
+	OpADDI,				OpADDQ,				OpADDX,				OpAND,
+	OpANDI,				OpASL,				OpASLMemory,		OpASR,
+	OpASRMemory,		OpBcc,				OpBCHGRegister,		OpBCHGImmediate,
+	OpBCLRRegister,		OpBCLRImmediate,	OpBSETRegister,		OpBSETImmediate,
+	OpBTSTRegister,		OpBTSTImmediate,	OpCHK,				OpCLR,
+	OpCMP,				OpCMPA,				OpCMPI,				OpCMPM,
+	OpDBcc,				OpDIVS,				OpDIVU,				OpEOR,
+	OpEORI,				OpEXG,				OpEXT,				OpJMP,
+	OpJSR,				OpLEA,				OpLINK,				OpLSL,
+	OpLSLMemory,		OpLSR,				OpLSRMemory,		OpMOVE,
+	OpMOVEtoCCR,		OpMOVEtoSR,			OpMOVEfromSR,		OpMOVEUSP,
+	OpMOVEA,			OpMOVEM,			OpMOVEP,			OpMOVEQ,
+	OpMULS,				OpMULU,				OpNBCD,				OpNEG,
+	OpNEGX,				OpNOP,				OpNOT,				OpOR,
+	OpORI,				OpPEA,				OpRESET,			OpROR,
+	OpRORMemory,		OpROL,				OpROLMemory,		OpROXL,
+	OpROXLMemory,		OpROXR,				OpROXRMemory,		OpRTE,
+	OpRTR,				OpRTS,				OpSBCD,				OpScc,
+	OpSTOP,				OpSUB,				OpSUBA,				OpSUBI,
+	OpSUBQ,				OpSUBX,				OpSWAP,				OpTAS,
+	OpTRAP,				OpTRAPV,			OpTST,				OpUNLK
+};
+
+struct Dis68kInstruction {
+	uint32_t address;
+	uint16_t opcode;		// the first word
+	uint8_t opnum;			// index into optab
+	uint8_t length;			// in bytes, including extension words
+	uint8_t size;			// an OperandSize
+	uint8_t flow;			// a Flow
+	uint8_t condition;		// for Bcc, DBcc and Scc
+	uint8_t operand_count;
+	Dis68kOperand operands[2];	// in the order written
+	uint32_t target;		// valid if has_target: the destination of a branch, or of a JMP or JSR to a known address
+	bool has_target;
+};
+
+/// The longest name, in characters, that a visitor's symbol may return; operand text is sized to hold it.
+const size_t kMaxSymbolName = 64;
+
+/// Room for one operand's text: a name of kMaxSymbolName characters, a size suffix and the terminator.
+const size_t kMaxOperandText = kMaxSymbolName + 16;
+
+/*!
+	The base for decode visitors. A visitor derives from this and declares
+	whichever handlers it wants; decode calls them statically, so handlers it
+	doesn't declare, and text it doesn't ask for, cost nothing.
+*/
+struct Dis68kVisitor {
+	/// Set to @c true in a visitor that wants on_text.
+	static const bool wants_text = false;
+
+	/// The output syntax policy that text is composed in.
+	typedef MotorolaSyntax syntax;
+
+	void on_instruction(const Dis68kInstruction &) {}
+	void on_operand(const Dis68kInstruction &, int, const Dis68kOperand &) {}
+	void on_branch_target(const Dis68kInstruction &, uint32_t) {}
+	void on_text(const char *, const char *) {}
+	void on_invalid(uint32_t, uint16_t) {}
+
+	/*!
+		@returns A name to print for the absolute address or branch target
+			@c address, or null to print it in hex. Only asked of visitors that
+			want text. Names may be at most kMaxSymbolName characters long.
+	*/
+	const char *symbol(uint32_t) { return nullptr; }
+};
+
+/// The decode visitor behind disasm: renders each instruction in @c Syntax.
+template<typename Syntax>
+struct TextVisitor: public Dis68kVisitor {
+	static const bool wants_text = true;
+	typedef Syntax syntax;
+
+	TextVisitor(char *_out_s, size_t _out_sz) : out_s(_out_s), out_sz(_out_sz) {}
+
+	void on_text(const char *opcode_s, const char *operand_s)
+	{
+		format_line<Syntax>(out_s, out_sz, opcode_s, operand_s);
+	}
+
+	char *out_s;
+	size_t out_sz;
+};
+
+/*!
+	A 68000 disassembler reading its input through @c View; see views.h.
+*/
+template<typename View>
+class BasicDis68k
 {
 public:
-	Dis68k(const void *_begin, const void *_end, uint32_t _address)
+	BasicDis68k(const View &_view, uint32_t _address) : view(_view)
+	{
+		overflow = false;
+		address = _address;
+	}
+
+	/// Constructs a disassembler for the image [@c _begin, @c _end) located at @c _address.
+	BasicDis68k(const void *_begin, const void *_end, uint32_t _address) : view(_begin, _end, _address)
 	{
-		begin = (const uint8_t *)_begin;
-		end = (const uint8_t *)_end;
-		cur = begin;
 		overflow = false;
 		address = _address;
 	}
 
-	bool disasm(uint32_t *inst_address, char *decoded_str, size_t decoded_len);
+	/*!
+		Decodes the instruction at the current address into @c decoded_str,
+		rendered in the syntax described by the @c Syntax policy.
+
+		@returns @c true if an instruction was decoded; @c false otherwise, in
+			which case @c decoded_str holds "???".
+	*/
+	template<typename Syntax = MotorolaSyntax>
+	bool disasm(uint32_t *inst_address, char *decoded_str, size_t decoded_len)
+	{
+		TextVisitor<Syntax> visitor(decoded_str, decoded_len);
+
+		snprintf(decoded_str, decoded_len, "???\n");
+		*inst_address = address;
+		return decode(visitor);
+	}
+
+	/*!
+		Decodes the instruction at the current address, reporting it to
+		@c visitor; see Dis68kVisitor.
+
+		@returns @c true if an instruction was decoded.
+	*/
+	template<typename Visitor>
+	bool decode(Visitor &visitor);
+
+	/// Decodes the instruction at the current address into @c inst.
+	bool decode(Dis68kInstruction &inst)
+	{
+		struct RecordVisitor: public Dis68kVisitor {
+			Dis68kInstruction *inst;
+			void on_instruction(const Dis68kInstruction &decoded) { *inst = decoded; }
+		} visitor;
+
+		visitor.inst = &inst;
+		return decode(visitor);
+	}
+
+	/*!
+		Moves decoding to @c _address.
+
+		@returns @c false if @c _address lies outside the input, in which case
+			decoding from there will overflow.
+	*/
+	bool seek(uint32_t _address)
+	{
+		address = _address;
+		overflow = false;
+		return view.contains(_address);
+	}
+
+	/// @returns The address of the next byte to be decoded.
+	uint32_t tell() const
+	{
+		return address;
+	}
+
+	/// @returns @c true if decoding has tried to read beyond the input since construction or the last seek.
+	bool overflowed() const
+	{
+		return overflow;
+	}
+
+	/// Reads the byte at @c _address without moving the decoding position.
+	bool peekbyte(uint32_t _address, uint8_t &res) const
+	{
+		return view.byte(_address, res);
+	}
+
+	/// Reads the word at @c _address without moving the decoding position.
+	bool peekword(uint32_t _address, uint16_t &res) const
+	{
+		return view.word(_address, res);
+	}
+
+	typedef bool (BasicDis68k::*DisasmFn)(uint32_t *inst_address, char *decoded_str, size_t decoded_len);
+
+	/*!
+		@returns The specialisation of @c disasm for @c syntax, for callers that
+			choose the output syntax at startup.
+	*/
+	static DisasmFn disasm_for(OutputSyntax syntax)
+	{
+		switch( syntax )
+		{
+			default:
+			case OutputSyntax::Motorola:		return &BasicDis68k::template disasm<MotorolaSyntax>;
+			case OutputSyntax::MotorolaLower:	return &BasicDis68k::template disasm<MotorolaLowerSyntax>;
+			case OutputSyntax::Devpac:			return &BasicDis68k::template disasm<DevpacSyntax>;
+			case OutputSyntax::DevpacLower:		return &BasicDis68k::template disasm<DevpacLowerSyntax>;
+			case OutputSyntax::Gnu:				return &BasicDis68k::template disasm<GnuSyntax>;
+		}
+	}
 
 private:
+
 	uint8_t getbyte()
 	{
-		if( cur < end )
+		uint8_t res;
+		if( view.byte(address, res) )
 		{
-			uint8_t res = 0;
-			res = *cur;
-			cur++;
 			address++;
 			return res;
 		}
@@ -36,10 +400,9 @@ private:
 
 	uint16_t getword()
 	{
-		if( cur < ( end - 1 ) )
+		uint16_t res;
+		if( view.word(address, res) )
 		{
-			uint16_t res = (cur[0] << 8) | cur[1];
-			cur += 2;
 			address += 2;
 			return res;
 		}
@@ -50,13 +413,30 @@ private:
 	}
 
 
-	void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, char *out_s, int out_sz);
+	template<typename Syntax, bool Text>
+	void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, Dis68kOperand &op, char *out_s, int out_sz);
 
-	const uint8_t *begin;
-	const uint8_t *end;
-	const uint8_t *cur;
+	View view;
 	uint32_t address;
 	bool overflow;
 };
 
+/// The disassembler for a single contiguous big-endian image.
+typedef BasicDis68k<ContiguousView> Dis68k;
+
+#include "dis68k_decode.h"
+
+/* The text decoders are compiled once, in dis68k.cpp. */
+#define DIS68K_TEXT_DECODERS(prefix, view)	\
+	prefix template bool BasicDis68k<view>::decode(TextVisitor<MotorolaSyntax> &);		\
+	prefix template bool BasicDis68k<view>::decode(TextVisitor<MotorolaLowerSyntax> &);	\
+	prefix template bool BasicDis68k<view>::decode(TextVisitor<DevpacSyntax> &);		\
+	prefix template bool BasicDis68k<view>::decode(TextVisitor<DevpacLowerSyntax> &);	\
+	prefix template bool BasicDis68k<view>::decode(TextVisitor<GnuSyntax> &);
+
+DIS68K_TEXT_DECODERS(extern, ContiguousView)
+DIS68K_TEXT_DECODERS(extern, InterleavedView)
+DIS68K_TEXT_DECODERS(extern, WordSwappedView)
+DIS68K_TEXT_DECODERS(extern, SegmentedView)
+
 #endif // DIS68K_H
@@ -0,0 +1,1321 @@
+#if !defined( DIS68K_DECODE_H )
+#define DIS68K_DECODE_H 1
+
+/*	The decoder proper, included by dis68k.h: the opcode tables and the body of
+	BasicDis68k::decode, which is a template on its visitor; see dis68k.cpp for
+	its history. The tables live in dis68k_detail and the macros are undefined
+	again at the end, so that includers see only the classes in dis68k.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "instrument.h"
+
+// Enable the #define below to print diagnostics.
+//#define PRINT_DIAGNOSTICS
+
+#ifdef PRINT_DIAGNOSTICS
+#define diagnostic_printf printf
+#else
+#define diagnostic_printf(...) while(false);
+#endif
+
+/*	The instrumentation hooks; see instrument.h. */
+#ifdef DIS68K_INSTRUMENT
+
+#if defined( DIS68K_INSTRUMENT_CYCLES ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <x86intrin.h>
+#define instrument_clock() __rdtsc()
+#else
+#define instrument_clock() uint64_t(0)
+#endif
+
+#define instrument_begin()							\
+	Dis68kCounters &instrument_local = instrument_counters();	\
+	const uint64_t instrument_start = instrument_clock();
+
+#define instrument_candidate(opnum, accepted)		\
+	if (!(accepted)) ++instrument_local.failed[opnum];
+
+#define instrument_end(opnum, decoded, length) {	\
+	if (decoded) {									\
+		++instrument_local.hits[opnum];				\
+		++instrument_local.instructions;			\
+	} else {										\
+		++instrument_local.undecoded;				\
+	}												\
+	instrument_local.bytes += (length);				\
+	instrument_record_cycles(instrument_local, (decoded) ? instruction_class(opnum) : ClassUndecoded, instrument_clock() - instrument_start); }
+
+#else
+
+#define instrument_begin()
+#define instrument_candidate(opnum, accepted)
+#define instrument_end(opnum, decoded, length)
+
+#endif // DIS68K_INSTRUMENT
+
+/* Internal to the decoder. */
+namespace dis68k_detail {
+
+/*!
+	Prints to a fixed-size buffer if @c Enabled; otherwise does nothing beyond
+	evaluating its arguments, so that text the visitor doesn't want costs nothing.
+*/
+template<bool Enabled>
+struct TextPrinter {
+	template<size_t N, typename... Args>
+	void operator()(char (&dest)[N], const char *fmt, Args... args) const {
+		if (Enabled) snprintf(dest, N, fmt, args...);
+	}
+};
+
+/// Prints a mnemonic as TextPrinter does, in the case @c Syntax asks for.
+template<bool Enabled, typename Syntax>
+struct MnemonicPrinter {
+	template<size_t N, typename... Args>
+	void operator()(char (&dest)[N], const char *fmt, Args... args) const {
+		if (!Enabled) return;
+		snprintf(dest, N, fmt, args...);
+		if (Syntax::lowercase) {
+			for (char *p = dest; *p; ++p) {
+				if (*p >= 'A' && *p <= 'Z') *p += 'a' - 'A';
+			}
+		}
+	}
+};
+
+struct OpcodeDetails {
+	uint16_t mask;
+	uint16_t value;
+};
+
+const struct OpcodeDetails optab[88] = {
+	{0x0000,0x0000}, {0xF1F0,0xC100}, {0xF000,0xD000}, {0xF0C0,0xD0C0},
+	{0xFF00,0x0600}, {0xF100,0x5000}, {0xF130,0xD100}, {0xF000,0xC000},
+	{0xFF00,0x0200}, {0xF118,0xE100}, {0xFFC0,0xE1C0}, {0xF118,0xE000},
+	{0xFFC0,0xE0C0}, {0xF000,0x6000}, {0xF1C0,0x0140}, {0xFFC0,0x0840},
+	{0xF1C0,0x0180}, {0xFFC0,0x0880}, {0xF1C0,0x01C0}, {0xFFC0,0x08C0},
+	{0xF1C0,0x0100}, {0xFFC0,0x0800}, {0xF1C0,0x4180}, {0xFF00,0x4200},
+	{0xF100,0xB000}, {0xF0C0,0xB0C0}, {0xFF00,0x0C00}, {0xF138,0xB108},
+	{0xF0F8,0x50C8}, {0xF1C0,0x81C0}, {0xF1C0,0x80C0}, {0xF100,0xB100},
+	{0xFF00,0x0A00}, {0xF100,0xC100}, {0xFFB8,0x4880}, {0xFFC0,0x4EC0},
+	{0xFFC0,0x4E80}, {0xF1C0,0x41C0}, {0xFFF8,0x4E50}, {0xF118,0xE108},
+	{0xFFC0,0xE3C0}, {0xF118,0xE008}, {0xFFC0,0xE2C0}, {0xC000,0x0000},
+	{0xFFC0,0x44C0}, {0xFFC0,0x46C0}, {0xFFC0,0x40C0}, {0xFFF0,0x4E60},
+	{0xC1C0,0x0040}, {0xFB80,0x4880}, {0xF138,0x0108}, {0xF100,0x7000},
+	{0xF1C0,0xC1C0}, {0xF1C0,0xC0C0}, {0xFFC0,0x4800}, {0xFF00,0x4400},
+	{0xFF00,0x4000}, {0xFFFF,0x4E71}, {0xFF00,0x4600}, {0xF000,0x8000},
+	{0xFF00,0x0000}, {0xFFC0,0x4840}, {0xFFFF,0x4E70}, {0xF118,0xE118},
+	{0xFFC0,0xE7C0}, {0xF118,0xE018}, {0xFFC0,0xE6C0}, {0xF118,0xE110},
+	{0xFFC0,0xE5C0}, {0xF118,0xE010}, {0xFFC0,0xE4C0}, {0xFFFF,0x4E73},
+	{0xFFFF,0x4E77}, {0xFFFF,0x4E75}, {0xF1F0,0x8100}, {0xF0C0,0x50C0},
+	{0xFFFF,0x4E72}, {0xF000,0x9000}, {0xF0C0,0x90C0}, {0xFF00,0x0400},
+	{0xF100,0x5100}, {0xF130,0x9100}, {0xFFF8,0x4840}, {0xFFC0,0x4AC0},
+	{0xFFF0,0x4E40}, {0xFFFF,0x4E76}, {0xFF00,0x4A00}, {0xFFF8,0x4E58}
+};
+
+const char bra_tab[][4] = {
+	"BRA",	"BSR",	"BHI",	"BLS",
+	"BCC",	"BCS",	"BNE",	"BEQ",
+	"BVC",	"BVS",	"BPL",	"BMI",
+	"BGE",	"BLT",	"BGT",	"BLE"
+};
+const char scc_tab[][4] = {
+	"ST",	"SF",	"SHI",	"SLS",
+	"SCC",	"SCS",	"SNE",	"SEQ",
+	"SVC",	"SVS",	"SPL",	"SMI",
+	"SGE",	"SLT",	"SGT",	"SLE"
+};
+const char size_arr[3] = {'B','W','L'};
+
+/*!
+	Decodes the addressing mode from @c instruction.
+
+	@returns A mode in the range 0 to 11, if a valid addressing mode could be
+		determined; 12 otherwise.
+*/
+inline int getmode(int instruction) {
+	const int mode = (instruction & 0x0038) >> 3;
+	const int reg = instruction & 0x0007;
+
+	if (mode == 7) {
+		if (reg >= 5) {
+			return 12; /* i.e. invalid */
+		} else {
+			return 7 + reg;
+		}
+	}
+	return mode;
+}
+
+}
+
+/*!
+	Reads the addressing mode @c mode, using @c reg and @c size, into @c op,
+	consuming any extension words; if @c Text, also prints it to @c out_s in
+	@c Syntax.
+
+	@param mode 0 to 11, indicating addressing mode.
+	@param size 0 = byte, 1 = word, 2 = long.
+*/
+template<typename View>
+template<typename Syntax, bool Text>
+void BasicDis68k<View>::sprintmode(unsigned int mode, unsigned int reg, unsigned int size, Dis68kOperand &op, char *out_s, int out_sz) {
+	const char ir[2] = {'W','L'}; /* for mode 6 */
+	const char ir_lower[2] = {'w','l'};
+	const char *const isizes = Syntax::lowercase ? ir_lower : ir;
+	const char *const A = Syntax::address_register;
+
+	op.mode = uint8_t(mode);
+	op.reg = uint8_t(reg);
+	op.index = 0;
+	op.displacement = 0;
+	op.value = 0;
+
+	switch(mode) {
+		case 0  : if (Text) snprintf(out_s, out_sz, "%s%i", Syntax::data_register, reg);	break;
+		case 1  : if (Text) snprintf(out_s, out_sz, "%s%i", A, reg);		break;
+		case 2  : if (Text) snprintf(out_s, out_sz, "(%s%i)", A, reg);		break;
+		case 3  : if (Text) snprintf(out_s, out_sz, "(%s%i)+", A, reg);	break;
+		case 4  : if (Text) snprintf(out_s, out_sz, "-(%s%i)", A, reg);	break;
+		case 5  : /* reg + disp */
+		case 9  : { /* pcr + disp */
+			int32_t displacement = (int32_t) getword();
+			if (displacement >= 32768) displacement -= 65536;
+			op.displacement = displacement;
+			if (mode == 5) {
+				if (Text) snprintf(out_s, out_sz, "%+i(%s%i)", displacement, A, reg);
+			} else {
+				const uint32_t ldata = address - 2 + displacement;
+				op.value = ldata;
+				if (Text && Syntax::pc_comments) {
+					snprintf(out_s, out_sz, "%+i(%s) {%s%08x}", displacement, Syntax::pc, Syntax::hex, ldata);
+				} else if (Text) {
+					snprintf(out_s, out_sz, "%+i(%s)", displacement, Syntax::pc);
+				}
+			}
+		} break;
+		case 6  : /* Areg with index + disp */
+		case 10 : {/* PC with index + disp */
+			const int data = getword(); /* index and displacement data */
+
+			int displacement = (data & 0x00FF);
+			if (displacement >= 128) displacement -= 256;
+
+			const int ireg = (data & 0x7000) >> 12;
+			const int itype = (data & 0x8000); /* == 0 is Dreg */
+			const int isize = (data & 0x0800) >> 11; /* == 0 is .W else .L */
+
+			op.displacement = displacement;
+			op.index = uint8_t(ireg | (itype ? Dis68kOperand::IndexAddressRegister : 0) | (isize ? Dis68kOperand::IndexLong : 0));
+			if (mode == 10) op.value = address - 2 + displacement;
+
+			if (!Text) break;
+			const char *const index_register = (itype == 0) ? Syntax::data_register : A;
+			if (mode == 6) {
+				snprintf(out_s, out_sz, "%+i(%s%i,%s%i.%c)", displacement, A, reg, index_register, ireg, isizes[isize]);
+			} else { /* PC */
+				snprintf(out_s, out_sz, "%+i(%s,%s%i.%c)", displacement, Syntax::pc, index_register, ireg, isizes[isize]);
+			}
+		} break;
+		case 7  : {
+			const int data = getword();
+			op.value = uint32_t(int32_t(int16_t(data))); /* sign extended */
+			if (Text) snprintf(out_s, out_sz, "%s0000%04x", Syntax::hex, data);
+		} break;
+		case 8  : {
+			const int data1 = getword();
+			const int data2 = getword();
+			op.value = (uint32_t(data1) << 16) | uint32_t(data2);
+			if (Text) snprintf(out_s, out_sz, "%s%04x%04x", Syntax::hex, data1, data2);
+		} break;
+		case 11 : {
+			const int data1 = getword();
+			switch(size) {
+				case 0 :
+					op.value = data1 & 0x00FF;
+					if (Text) snprintf(out_s, out_sz, "#%s%02x", Syntax::hex, (data1 & 0x00FF));
+					break;
+				case 1 :
+					op.value = data1;
+					if (Text) snprintf(out_s, out_sz, "#%s%04x", Syntax::hex, data1);
+					break;
+				case 2 : {
+					const int data2 = getword();
+					op.value = (uint32_t(data1) << 16) | uint32_t(data2);
+					if (Text) snprintf(out_s, out_sz, "#%s%04x%04x", Syntax::hex, data1, data2);
+				} break;
+			}
+		} break;
+		default : fprintf(stderr, "Mode out of range in sprintmode = %i\n", mode);
+			op.mode = ModeNone;
+			if (Text) snprintf(out_s, out_sz, "?");
+			break;
+	}
+}
+
+template<typename View>
+template<typename Visitor>
+bool BasicDis68k<View>::decode(Visitor &visitor) {
+	using namespace dis68k_detail;
+
+	const uint32_t start_address = address;
+	const int word = getword();
+	bool decoded = false;
+	int opnum = 1;
+
+	instrument_begin();
+
+	/* Text is composed only for visitors that want it, in the visitor's syntax. */
+	typedef typename Visitor::syntax Syntax;
+	const bool text = Visitor::wants_text;
+	const TextPrinter<Visitor::wants_text> textf;
+	const MnemonicPrinter<Visitor::wants_text, Syntax> mnemonicf;
+	const char *const D = Syntax::data_register;
+	const char *const A = Syntax::address_register;
+	const char *const hex = Syntax::hex;
+	char opcode_s[50], operand_s[2 * kMaxOperandText + 1] = "";
+
+	Dis68kInstruction inst;
+	inst.address = start_address;
+	inst.opcode = uint16_t(word);
+
+	/* Captures an effective address as operand @c index, in the order written. */
+	const auto ea = [&](int index, unsigned int mode, unsigned int reg, unsigned int size, char *out_s, int out_sz) {
+		sprintmode<Syntax, Visitor::wants_text>(mode, reg, size, inst.operands[index], out_s, out_sz);
+		if (inst.operand_count <= index) inst.operand_count = uint8_t(index + 1);
+		if (text && (mode == ModeAbsoluteShort || mode == ModeAbsoluteLong)) {
+			const char *const name = visitor.symbol(inst.operands[index].value);
+			if (name) snprintf(out_s, out_sz, "%s%s", name, (mode == ModeAbsoluteShort) ? Syntax::short_suffix : "");
+		}
+	};
+	/* Captures any other operand. */
+	const auto operand = [&](int index, unsigned int mode, unsigned int reg, uint32_t value) {
+		Dis68kOperand &op = inst.operands[index];
+		op.mode = uint8_t(mode);
+		op.reg = uint8_t(reg);
+		op.index = 0;
+		op.displacement = 0;
+		op.value = value;
+		if (inst.operand_count <= index) inst.operand_count = uint8_t(index + 1);
+	};
+	const auto branch = [&](unsigned int flow, uint32_t target) {
+		inst.flow = uint8_t(flow);
+		inst.target = target;
+		inst.has_target = true;
+	};
+	/* Prints a branch target, by name if the visitor has one for it. */
+	const auto target_text = [&](char *out_s, int out_sz, uint32_t target) {
+		if (!text) return;
+		const char *const name = visitor.symbol(target);
+		if (name) {
+			snprintf(out_s, out_sz, "%s", name);
+		} else {
+			snprintf(out_s, out_sz, "%s%08x", hex, target);
+		}
+	};
+
+	for (; opnum <= 87; ++opnum) {
+		if ((word & optab[opnum].mask) == optab[opnum].value) {
+			/* Diagnostic code */
+			diagnostic_printf("(%i) ",opnum);
+
+			inst.size = SizeNone;
+			inst.flow = FlowSequential;
+			inst.condition = 0;
+			inst.operand_count = 0;
+			inst.has_target = false;
+			inst.target = 0;
+
+			switch(opnum) { /* opnum = 1..85 */
+				case 1  :
+				case 74 : { /* ABCD + SBCD */
+					const int sreg = word & 0x0007;
+					const int dreg = (word & 0x0E00) >> 9;
+					if (opnum == 1) {
+						mnemonicf(opcode_s, "ABCD");
+					} else {
+						mnemonicf(opcode_s, "SBCD");
+					}
+					inst.size = SizeByte;
+					if ((word & 0x0008) == 0) {
+						/* reg-reg */
+						operand(0, ModeDataRegister, sreg, 0);
+						operand(1, ModeDataRegister, dreg, 0);
+						textf(operand_s, "%s%i,%s%i", D, sreg, D, dreg);
+					} else {
+						/* mem-mem */
+						operand(0, ModePreDecrement, sreg, 0);
+						operand(1, ModePreDecrement, dreg, 0);
+						textf(operand_s, "-(%s%i),-(%s%i)", A, sreg, A, dreg);
+					}
+					decoded = true;
+				} break;
+				case 2  :
+				case 7  :
+				case 31 :
+				case 59 : /* ADD, AND, EOR, OR */
+				case 77 : { /* SUB */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+
+					/* Diagnostic code */
+					diagnostic_printf("dmode = %i, dreg = %i, size = %i",dmode,dreg,size);
+
+					if (size == 3) break;
+					if (dmode == 12) break; /* Invalid */
+					/*
+					if (dmode == 1) break;
+					*/
+					if ((opnum ==  2) && (dmode == 1) && (size == 0)) break;
+					if ((opnum == 77) && (dmode == 1) && (size == 0)) break;
+
+					const int dir = (word & 0x0100) >> 8; /* 0 = dreg dest */
+					if ((opnum == 31) && (dir == 0)) break;
+					/* dir == 1 : Dreg is source */
+					if ((dir == 1) && (dmode >= 9)) break;
+
+					switch(opnum) {
+						case  2 : mnemonicf(opcode_s, "ADD.%c", size_arr[size]);
+							break;
+						case  7 : mnemonicf(opcode_s,"AND.%c", size_arr[size]);
+							break;
+						case 31 : mnemonicf(opcode_s, "EOR.%c", size_arr[size]);
+							break;
+						case 59 : mnemonicf(opcode_s, "OR.%c", size_arr[size]);
+							break;
+						case 77 : mnemonicf(opcode_s, "SUB.%c", size_arr[size]);
+							break;
+					}
+
+					inst.size = uint8_t(size);
+					char dest_s[kMaxOperandText];
+					ea(dir ? 1 : 0, dmode, dreg, size, dest_s, sizeof(dest_s));
+
+					const int sreg = (word & 0x0E00) >> 9;
+					char source_s[kMaxOperandText];
+					operand(dir ? 0 : 1, ModeDataRegister, sreg, 0);
+					textf(source_s, "%s%i", D, sreg);
+					/* reverse source & dest if dir == 0 */
+					if (dir != 0) {
+						textf(operand_s, "%s,%s", source_s, dest_s);
+					} else {
+						textf(operand_s, "%s,%s", dest_s, source_s);
+					}
+					decoded = true;
+				} break;
+				case 3  :
+				case 78 : { /* ADDA + SUBA */
+					const int smode = getmode(word);
+					const int sreg = word & 0x0007;
+					const int dreg = (word & 0x0E00) >> 9;
+					const int size = ((word & 0x0100) >> 8) + 1;
+					if (smode == 12) break; /* Invalid */
+					switch(opnum) {
+						case  3 : mnemonicf(opcode_s, "ADDA.%c", size_arr[size]);
+							break;
+						case 78 : mnemonicf(opcode_s, "SUBA.%c", size_arr[size]);
+							break;
+					}
+					inst.size = uint8_t(size);
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					operand(1, ModeAddressRegister, dreg, 0);
+					textf(operand_s, "%s,%s%i", source_s, A, dreg);
+					decoded = true;
+				} break;
+				case 4  :
+				case 8  :
+				case 26 :
+				case 32 :
+				case 60 :
+				case 79 : { /* ADDI, ANDI, CMPI, EORI, ORI, SUBI */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+
+					if (size == 3) break;
+					if (dmode == 1) break;
+					if ((dmode == 9) || (dmode == 10)) break; /* Invalid */
+					if (dmode == 12) break;
+					if ((dmode == 11) && /* ADDI, CMPI, SUBI */
+						((opnum == 4) || (opnum == 26) || (opnum == 79))) break;
+
+					switch(opnum) {
+						case  4 : mnemonicf(opcode_s, "ADDI.%c", size_arr[size]);
+							break;
+						case  8 : mnemonicf(opcode_s, "ANDI.%c", size_arr[size]);
+							break;
+						case 26 : mnemonicf(opcode_s, "CMPI.%c", size_arr[size]);
+							break;
+						case 32 : mnemonicf(opcode_s, "EORI.%c", size_arr[size]);
+							break;
+						case 60 : mnemonicf(opcode_s, "ORI.%c", size_arr[size]);
+							break;
+						case 79 : mnemonicf(opcode_s, "SUBI.%c", size_arr[size]);
+							break;
+					}
+
+					inst.size = uint8_t(size);
+					const int data = getword();
+					char source_s[kMaxOperandText];
+					switch(size) {
+						case 0 : textf(source_s, "#%s%02X", hex, (data & 0x00FF));
+							operand(0, ModeImmediate, 0, data & 0x00FF);
+							break;
+						case 1 : textf(source_s, "#%s%04X", hex, data);
+							operand(0, ModeImmediate, 0, data);
+							break;
+						case 2 : {
+							const int data2 = getword();
+							textf(source_s, "#%s%04X%04X", hex, data, data2);
+							operand(0, ModeImmediate, 0, (uint32_t(data) << 16) | uint32_t(data2));
+						} break;
+					}
+
+					char dest_s[kMaxOperandText];
+					if (dmode == 11) {
+						operand(1, (size == 0) ? ModeConditionCodes : ModeStatusRegister, 0, 0);
+						textf(dest_s, "%s", (size == 0) ? Syntax::ccr : Syntax::sr);
+					} else {
+						ea(1, dmode, dreg, size, dest_s, sizeof(dest_s));
+					}
+					textf(operand_s, "%s,%s", source_s, dest_s);
+					decoded = true;
+				} break;
+				case 5  :
+				case 80 : {/* ADDQ + SUBQ */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+
+					if (size == 3) break;
+					if (dmode >= 9) break;
+					if ((size == 0) && (dmode == 1)) break;
+
+					if (opnum == 5) {
+						mnemonicf(opcode_s,"ADDQ.%c",size_arr[size]);
+					} else {
+						mnemonicf(opcode_s,"SUBQ.%c",size_arr[size]);
+					}
+					inst.size = uint8_t(size);
+					char dest_s[kMaxOperandText];
+					const int count = (word & 0x0E00) >> 9;
+					operand(0, ModeQuick, 0, count ? count : 8);
+					ea(1, dmode, dreg, size, dest_s, sizeof(dest_s));
+					textf(operand_s, "#%i,%s", count ? count : 8, dest_s);
+					decoded = true;
+				} break;
+				case 6  :
+				case 81 : /* ADDX + SUBX */
+				case 27 : { /* CMPM */
+					const int size = (word & 0x00C0) >> 6;
+					if (size == 3) break;
+
+					const int sreg = word & 0x0007;
+					const int dreg = (word & 0x0E00) >> 9;
+					switch(opnum) {
+						case 6  : mnemonicf(opcode_s, "ADDX.%c", size_arr[size]);
+							break;
+						case 81 : mnemonicf(opcode_s, "SUBX.%c", size_arr[size]);
+							break;
+						case 27 : mnemonicf(opcode_s, "CMPM.%c", size_arr[size]);
+							break;
+					}
+					inst.size = uint8_t(size);
+					if ((opnum != 27) && ((word & 0x0008) == 0)) {
+						/* reg-reg */
+						operand(0, ModeDataRegister, sreg, 0);
+						operand(1, ModeDataRegister, dreg, 0);
+						textf(operand_s, "%s%i,%s%i", D, sreg, D, dreg);
+					} else {
+						/* mem-mem */
+						operand(0, ModePreDecrement, sreg, 0);
+						operand(1, ModePreDecrement, dreg, 0);
+						textf(operand_s, "-(%s%i),-(%s%i)", A, sreg, A, dreg);
+					}
+					if (opnum == 27) {
+						operand(0, ModePostIncrement, sreg, 0);
+						operand(1, ModePostIncrement, dreg, 0);
+						textf(operand_s, "(%s%i)+,(%s%i)+", A, sreg, A, dreg);
+					}
+					decoded = true;
+				} break;
+				case 9  :
+				case 11 :
+				case 39 :
+				case 41 :
+				case 63 :
+				case 65 :
+				case 67 :
+				case 69 : { /* ASL, ASR, LSL, LSR, ROL, ROR, ROXL, ROXR */
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+					if (size == 3) break;
+
+					switch(opnum) {
+						case 9  : mnemonicf(opcode_s, "ASL.%c", size_arr[size]);
+							break;
+						case 11 : mnemonicf(opcode_s, "ASR.%c", size_arr[size]);
+							break;
+						case 39 : mnemonicf(opcode_s, "LSL.%c", size_arr[size]);
+							break;
+						case 41 : mnemonicf(opcode_s, "LSR.%c", size_arr[size]);
+							break;
+						case 63 : mnemonicf(opcode_s, "ROR.%c", size_arr[size]);
+							break;
+						case 65 : mnemonicf(opcode_s, "ROL.%c", size_arr[size]);
+							break;
+						case 67 : mnemonicf(opcode_s, "ROXL.%c", size_arr[size]);
+							break;
+						case 69 : mnemonicf(opcode_s, "ROXR.%c", size_arr[size]);
+							break;
+					}
+					inst.size = uint8_t(size);
+					int count = (word & 0x0E00) >> 9;
+					if (((word & 0x0020) >> 5) == 0) { /* imm */
+						if (count == 0) count = 8;
+						operand(0, ModeQuick, 0, count);
+						textf(operand_s, "#%i,%s%i", count, D, dreg);
+					} else { /* count in dreg */
+						operand(0, ModeDataRegister, count, 0);
+						textf(operand_s, "%s%i,%s%i", D, count, D, dreg);
+					}
+					operand(1, ModeDataRegister, dreg, 0);
+					decoded = true;
+				} break;
+				case 10 :
+				case 12 :
+				case 40 :
+				case 42 :
+				case 64 :
+				case 66 :
+				case 68 : /* Memory-to-memory */
+				case 70 : { /* ASL, ASR, LSL, LSR, ROL, ROR, ROXL, ROXR */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					if ((dmode <= 1) || (dmode >= 9)) break; /* Invalid */
+
+					switch(opnum) {
+						case 10 : mnemonicf(opcode_s,"ASL");
+							break;
+						case 12 : mnemonicf(opcode_s,"ASR");
+							break;
+						case 40 : mnemonicf(opcode_s,"LSL");
+							break;
+						case 42 : mnemonicf(opcode_s,"LSR");
+							break;
+						case 64 : mnemonicf(opcode_s,"ROR");
+							break;
+						case 66 : mnemonicf(opcode_s,"ROL");
+							break;
+						case 68 : mnemonicf(opcode_s,"ROXL");
+							break;
+						case 70 : mnemonicf(opcode_s,"ROXR");
+							break;
+					}
+					inst.size = SizeWord;
+					ea(0, dmode, dreg, 0, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 13 : {/* Bcc */
+					const int cc = (word & 0x0F00) >> 8;
+					mnemonicf(opcode_s, "%s", bra_tab[cc]);
+
+					inst.condition = uint8_t(cc);
+					const unsigned int flow = (cc == 0) ? FlowJump : ((cc == 1) ? FlowCall : FlowBranch);
+
+					int offset = (word & 0x00FF);
+					if (offset != 0) {
+						if (offset >= 128) offset -= 256;
+						inst.size = SizeByte;
+						branch(flow, address + offset);
+						target_text(operand_s, sizeof(operand_s), inst.target);
+					} else {
+						offset = getword();
+						if (offset >= 32768l) offset -= 65536l;
+						inst.size = SizeWord;
+						branch(flow, address - 2 + offset);
+						target_text(operand_s, sizeof(operand_s), inst.target);
+					}
+					operand(0, ModeBranchTarget, 0, inst.target);
+					decoded = true;
+				} break;
+				case 14 :
+				case 15 :
+				case 16 :
+				case 17 : /* BCHG + BCLR */
+				case 18 :
+				case 19 : /* BSET */
+				case 20 :
+				case 21 : {/* BTST */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+
+					if (dmode == 1) break;
+					if (dmode >= 11) break;
+					if ((opnum < 20) && (dmode >= 9)) break;
+
+					const int sreg = (word & 0x0E00) >> 9;
+					char source_s[kMaxOperandText];
+					switch(opnum) {
+						case 14 : /* BCHG_DREG */
+							mnemonicf(opcode_s, "BCHG");
+							operand(0, ModeDataRegister, sreg, 0);
+							textf(source_s, "%s%i", D, sreg);
+							break;
+						case 15 : {/* BCHG_IMM */
+							mnemonicf(opcode_s, "BCHG");
+							const int data = getword() & 0x002F;
+							operand(0, ModeImmediate, 0, data);
+							textf(source_s, "#%i", data);
+						} break;
+						case 16 : /* BCLR_DREG */
+							mnemonicf(opcode_s, "BCLR");
+							operand(0, ModeDataRegister, sreg, 0);
+							textf(source_s, "%s%i", D, sreg);
+							break;
+						case 17 : {/* BCLR_IMM */
+							mnemonicf(opcode_s, "BCLR");
+							const int data = getword() & 0x002F;
+							operand(0, ModeImmediate, 0, data);
+							textf(source_s, "#%i", data);
+						} break;
+						case 18 : /* BSET_DREG */
+							mnemonicf(opcode_s, "BSET");
+							operand(0, ModeDataRegister, sreg, 0);
+							textf(source_s, "%s%i", D, sreg);
+							break;
+						case 19 : { /* BSET_IMM */
+							mnemonicf(opcode_s, "BSET");
+							const int data = getword() & 0x002F;
+							operand(0, ModeImmediate, 0, data);
+							textf(source_s, "#%i", data);
+						} break;
+						case 20 : /* BTST_DREG */
+							mnemonicf(opcode_s,"BTST");
+							operand(0, ModeDataRegister, sreg, 0);
+							textf(source_s, "%s%i", D, sreg);
+							break;
+						case 21 : {/* BTST_IMM */
+							mnemonicf(opcode_s,"BTST");
+							const int data = getword() & 0x002F;
+							operand(0, ModeImmediate, 0, data);
+							textf(source_s, "#%i", data);
+						} break;
+					}
+					/* Long for a data register, otherwise byte */
+					inst.size = dmode ? SizeByte : SizeLong;
+					char dest_s[kMaxOperandText];
+					ea(1, dmode, dreg, 0, dest_s, sizeof(dest_s));
+					textf(operand_s, "%s,%s", source_s, dest_s);
+					decoded = true;
+				} break;
+				case 22 : /* CHK */
+				case 29 :
+				case 30 :
+				case 52 :
+				case 53 : /* DIVS, DIVU, MULS, MULU */
+				case 24 : {/* CMP */
+					const int smode = getmode(word);
+					if ((smode == 1) && (opnum != 24)) break;
+					if (smode >= 12) break;
+
+					const int sreg = word & 0x0007;
+					const int dreg = (word & 0x0E00) >> 9;
+
+					int size;
+					if (opnum == 24) {
+						size = (word & 0x00C0) >> 6;
+					} else {
+						size = 1; /* WORD */
+					}
+					if (size == 3) break;
+
+					switch(opnum) {
+						case 22 : /* CHK */
+							mnemonicf(opcode_s, "CHK");
+							break;
+						case 24 : /* CMP */
+							mnemonicf(opcode_s, "CMP.%c", size_arr[size]);
+							break;
+						case 29 : /* DIVS */
+							mnemonicf(opcode_s, "DIVS");
+							break;
+						case 30 : /* DIVU */
+							mnemonicf(opcode_s, "DIVU");
+							break;
+						case 52 : /* MULS */
+							mnemonicf(opcode_s, "MULS");
+							break;
+						case 53 : /* MULU */
+							mnemonicf(opcode_s, "MULU");
+							break;
+					}
+					inst.size = uint8_t(size);
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					operand(1, ModeDataRegister, dreg, 0);
+					textf(operand_s, "%s,%s%i", source_s, D, dreg);
+					decoded = true;
+				} break;
+				case 23 : {/* CLR */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					if ((dmode == 1) || (dmode >= 9)) break; /* Invalid */
+
+					const int size = (word & 0x00C0) >> 6;
+					if (size == 3) break;
+
+					inst.size = uint8_t(size);
+					mnemonicf(opcode_s, "CLR.%c", size_arr[size]);
+					ea(0, dmode, dreg, size, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 25 : {/* CMPA */
+					const int smode = getmode(word);
+					const int sreg = word & 0x0007;
+					const int areg = (word & 0x0E00) >> 9;
+					const int size = ((word & 0x0100) >> 8) + 1;
+					if (smode == 12) break; /* Invalid */
+
+					mnemonicf(opcode_s, "CMPA.%c", size_arr[size]);
+					inst.size = uint8_t(size);
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					operand(1, ModeAddressRegister, areg, 0);
+					textf(operand_s, "%s,%s%i", source_s, A, areg);
+					decoded = true;
+				} break;
+				case 28 : { /* DBcc */
+					const int cc = (word & 0x0F00) >> 8;
+					mnemonicf(opcode_s, "D%s", bra_tab[cc]);
+
+					if (cc == 0) mnemonicf(opcode_s, "DBT");
+					if (cc == 1) mnemonicf(opcode_s, "DBF");
+					int offset = getword();
+					if (offset >= 32768) offset -= 65536;
+					const int dreg = word & 0x0007;
+					inst.size = SizeWord;
+					inst.condition = uint8_t(cc);
+					branch(FlowBranch, address - 2 + offset);
+					operand(0, ModeDataRegister, dreg, 0);
+					operand(1, ModeBranchTarget, 0, inst.target);
+					char target_s[kMaxOperandText];
+					target_text(target_s, sizeof(target_s), inst.target);
+					textf(operand_s, "%s%i,%s", D, dreg, target_s);
+					decoded = true;
+				} break;
+				case 33 : { /* EXG */
+					const int dmode = (word & 0x00F8) >> 3;
+					/*	8 - Both Dreg
+						9 - Both Areg
+						17 - Dreg + Areg */
+					if ((dmode != 8) && (dmode != 9) && (dmode != 17)) break;
+
+					const int dreg = word & 0x0007;
+					const int areg = (word & 0x0E00) >> 9;
+					mnemonicf(opcode_s, "EXG");
+
+					inst.size = SizeLong;
+					switch(dmode) {
+						case 8  : textf(operand_s, "%s%i,%s%i", D, dreg, D, areg);
+							operand(0, ModeDataRegister, dreg, 0);
+							operand(1, ModeDataRegister, areg, 0);
+							break;
+						case 9  : textf(operand_s, "%s%i,%s%i", A, dreg, A, areg);
+							operand(0, ModeAddressRegister, dreg, 0);
+							operand(1, ModeAddressRegister, areg, 0);
+							break;
+						case 17 : textf(operand_s, "%s%i,%s%i", D, dreg, A, areg);
+							operand(0, ModeDataRegister, dreg, 0);
+							operand(1, ModeAddressRegister, areg, 0);
+							break;
+					}
+					decoded = true;
+				} break;
+				case 34 : {/* EXT */
+					const int dreg = word & 0x0007;
+					const int size = ((word & 0x0040) >> 6) + 1;
+					inst.size = uint8_t(size);
+					operand(0, ModeDataRegister, dreg, 0);
+					mnemonicf(opcode_s, "EXT.%c", size_arr[size]);
+					textf(operand_s, "%s%i", D, dreg);
+					decoded = true;
+				} break;
+				case 35 :
+				case 36 : {/* JMP + JSR */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+
+					if (dmode <= 1) break;
+					if ((dmode == 3) || (dmode == 4)) break;
+					if (dmode >= 11) break; /* Invalid */
+
+					switch(opnum) {
+						case 35 : mnemonicf(opcode_s, "JMP");
+							break;
+						case 36 : mnemonicf(opcode_s, "JSR");
+							break;
+					}
+
+					ea(0, dmode, dreg, 0, operand_s, sizeof(operand_s));
+					inst.flow = uint8_t((opnum == 35) ? FlowJump : FlowCall);
+					if ((dmode == 7) || (dmode == 8) || (dmode == 9)) {
+						branch(inst.flow, inst.operands[0].value);
+					}
+					decoded = true;
+				} break;
+				case 37 : {/* LEA */
+					const int smode = getmode(word);
+					if ((smode == 0) || (smode == 1)) break;
+					if ((smode == 3) || (smode == 4)) break;
+					if (smode >= 11) break;
+
+					const int sreg = word & 0x0007;
+					mnemonicf(opcode_s, "LEA");
+					inst.size = SizeLong;
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, 0, source_s, sizeof(source_s));
+
+					const int dreg = (word & 0x0E00) >> 9;
+					operand(1, ModeAddressRegister, dreg, 0);
+					textf(operand_s, "%s,%s%i", source_s, A, dreg);
+					decoded = true;
+				} break;
+				case 38 : {/* LINK */
+					const int areg = word & 0x0007;
+					int offset = getword();
+					if (offset >= 32768) offset -= 65536;
+					inst.size = SizeWord;
+					operand(0, ModeAddressRegister, areg, 0);
+					operand(1, ModeImmediate, 0, uint32_t(offset));
+					mnemonicf(opcode_s, "LINK");
+					textf(operand_s, "%s%i,#%+i", A, areg, offset);
+					decoded = true;
+				} break;
+				case 43 : {/* MOVE */
+					const int smode = getmode(word);
+					const int data = ((word & 0x0E00) >> 9) | ((word & 0x01C0) >> 3);
+					const int dmode = getmode(data);
+
+					const int sreg = word & 0x0007;
+					const int dreg = data & 0x0007;
+
+					int size = (word & 0x3000) >> 12; /* 1=B, 2=L, 3=W */
+					if (size == 0) break;
+					switch(size) {
+						case 1 : size = 0;
+							break;
+						case 2 : size = 2;
+							break;
+						case 3 : size = 1;
+							break;
+					}
+					/* 0=B, 1=W, 2=L */
+
+					/*
+					printf("smode = %i dmode = %i ",smode,dmode);
+					printf("sreg = %i dreg = %i \n",sreg,dreg);
+					*/
+
+					/* check for illegal modes */
+					// smode=1, size=1 is legal; 36 0d
+					// if ((smode == 1) && (size == 1)) break;
+					// smode=9 is legal; 2d 40 ff ec
+					// smode=10 is legal; 30 3b 00 00
+					// if ((smode == 9) || (smode == 10)) break;
+					if (smode > 11) break;
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+
+					mnemonicf(opcode_s,"MOVE.%c",size_arr[size]);
+
+					inst.size = uint8_t(size);
+					char source_s[kMaxOperandText], dest_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					ea(1, dmode, dreg, size, dest_s, sizeof(dest_s));
+					textf(operand_s, "%s,%s", source_s, dest_s);
+					decoded = true;
+				} break;
+				case 44 : /* MOVE to CCR */
+				case 45 : {/* MOVE to SR */
+					const int smode = getmode(word);
+					const int sreg = word & 0x0007;
+					const int size = 1; /* WORD */
+
+					if (smode == 1) break;
+					if (smode >= 12) break;
+
+					mnemonicf(opcode_s, "MOVE.W");
+					inst.size = SizeWord;
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					operand(1, (opnum == 44) ? ModeConditionCodes : ModeStatusRegister, 0, 0);
+					textf(operand_s, "%s,%s", source_s, (opnum == 44) ? Syntax::ccr : Syntax::sr);
+					decoded = true;
+				} break;
+				case 46 : {/* MOVE from SR */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = 1; /* WORD */
+
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+
+					mnemonicf(opcode_s, "MOVE.W");
+					inst.size = SizeWord;
+					char dest_s[kMaxOperandText];
+					operand(0, ModeStatusRegister, 0, 0);
+					ea(1, dmode, dreg, size, dest_s, sizeof(dest_s));
+					textf(operand_s, "%s,%s", Syntax::sr, dest_s);
+					decoded = true;
+				} break;
+				case 47 : { /* MOVE USP */
+					const int sreg = word & 0x0007;
+					inst.size = SizeLong;
+					mnemonicf(opcode_s, "MOVE");
+					if ((word & 0x0008) == 0) {
+						/* to USP */
+						operand(0, ModeAddressRegister, sreg, 0);
+						operand(1, ModeUserStackPointer, 0, 0);
+						textf(operand_s, "%s%i,%s", A, sreg, Syntax::usp);
+					} else {
+						/* from USP */
+						operand(0, ModeUserStackPointer, 0, 0);
+						operand(1, ModeAddressRegister, sreg, 0);
+						textf(operand_s, "%s,%s%i", Syntax::usp, A, sreg);
+					}
+					decoded = true;
+				} break;
+				case 48 : {/* MOVEA */
+					const int smode = getmode(word);
+					const int sreg = word & 0x0007;
+					int size = (word & 0x3000) >> 12;
+
+					/* 2 = L, 3 = W */
+					if (size <= 1) break;
+					if (smode == 12) break; /* Invalid */
+					if (size == 3) size = 1;
+					/* 1 = W, 2 = L */
+
+					const int dreg = (word & 0x0e00) >> 9;
+
+					mnemonicf(opcode_s, "MOVEA.%c", size_arr[size]);
+
+					inst.size = uint8_t(size);
+					char source_s[kMaxOperandText];
+					ea(0, smode, sreg, size, source_s, sizeof(source_s));
+					operand(1, ModeAddressRegister, dreg, 0);
+					textf(operand_s, "%s,%s%i", source_s, A, dreg);
+					decoded = true;
+				} break;
+				case 49 : {/* MOVEM */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = ((word & 0x0040) >> 6) + 1;
+
+					if ((dmode == 0) || (dmode == 1)) break;
+					if (dmode >= 11) break;
+
+					const int dir = (word & 0x0400) >> 10; /* 1 == from mem */
+					if ((dir == 0) && (dmode == 3)) break;
+					if ((dir == 1) && (dmode == 4)) break;
+
+					int data = getword();
+					if (dmode == 4) { /* dir == 0 if dmode == 4 !! */
+						/* reverse bits in data, to D0 in bit 0 as for the other modes */
+						int temp = data;
+						data = 0;
+						for (int i = 0; i <= 15; ++i) {
+							data = (data >> 1) | (temp & 0x8000);
+							temp = temp << 1;
+						}
+					}
+
+					char source_s[kMaxOperandText] = "";
+					char dest_s[kMaxOperandText] = "";
+
+					/**** DATA LIST ***/
+
+					int rlist[11];
+					for (int i = 0 ; i <= 7; ++i) {
+						rlist[i + 1] = (data >> i) & 0x0001;
+					}
+					rlist[0] = 0;
+					rlist[9] = 0;
+					rlist[10] = 0;
+
+					for (int i = 1; i <= 8 ; ++i) {
+						if ((rlist[i-1] == 0) && (rlist[i] == 1) &&
+							(rlist[i+1] == 1) && (rlist[i+2] == 1)) {
+							/* first reg in list */
+							char temp_s[50];
+							textf(temp_s, "%s%i-", D, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+						if ((rlist[i] == 1) && (rlist[i+1] == 0)) {
+							char temp_s[50];
+							textf(temp_s, "%s%i/", D, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+						if ((rlist[i-1] == 0) && (rlist[i] == 1) &&
+							(rlist[i+1] == 1) && (rlist[i+2] == 0)) {
+							char temp_s[50];
+							textf(temp_s, "%s%i/", D, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+					}
+
+					/**** ADDRESS LIST ***/
+
+					for (int i = 8; i <= 15; ++i) {
+						rlist[i - 7] = (data >> i) & 0x0001;
+					}
+					rlist[0] = 0;
+					rlist[9] = 0;
+					rlist[10] = 0;
+
+					for (int i = 1; i <= 8; ++i) {
+						if ((rlist[i-1] == 0) && (rlist[i] == 1) &&
+							(rlist[i+1] == 1) && (rlist[i+2] == 1)) {
+							/* first reg in list */
+							char temp_s[50];
+							textf(temp_s, "%s%i-", A, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+						if ((rlist[i] == 1) && (rlist[i+1] == 0)) {
+							char temp_s[50];
+							textf(temp_s, "%s%i/", A, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+						if ((rlist[i-1] == 0) && (rlist[i] == 1) &&
+							(rlist[i+1] == 1) && (rlist[i+2] == 0)) {
+							char temp_s[50];
+							textf(temp_s, "%s%i/", A, i - 1);
+							if (text) strcat(source_s, temp_s);
+						}
+					}
+
+					/* The captured list is always D0 in bit 0 through A7 in bit 15, whatever the mode. */
+					const uint32_t mask = uint32_t(data);
+
+					inst.size = uint8_t(size);
+					mnemonicf(opcode_s, "MOVEM.%c", size_arr[size]);
+					ea(dir ? 0 : 1, dmode, dreg, size, dest_s, sizeof(dest_s));
+					operand(dir ? 1 : 0, ModeRegisterList, 0, mask);
+					/* remove the trailing separator */
+					if (text && source_s[0]) source_s[strlen(source_s)-1] = 0;
+					if (dir == 0) {
+						textf(operand_s, "%s,%s", source_s, dest_s);
+					} else {
+						textf(operand_s, "%s,%s", dest_s, source_s);
+					}
+					decoded = true;
+				} break;
+				case 50 : {/* MOVEP */
+					const int dreg = (word & 0x0E00) >> 9;
+					const int areg = word & 0x0007;
+					const int size = ((word & 0x0040) >> 6) + 1;
+
+					if (size == 3) break;
+
+					const int data = getword();
+					inst.size = uint8_t(size);
+					mnemonicf(opcode_s, "MOVEP.%c", size_arr[size]);
+					const int memory = ((word & 0x0080) == 0) ? 0 : 1;
+					operand(1 - memory, ModeDataRegister, dreg, 0);
+					operand(memory, ModeDisplacement, areg, 0);
+					inst.operands[memory].displacement = int16_t(data);
+					if ((word & 0x0080) == 0) {
+						/* mem -> data reg */
+						textf(operand_s, "%s%04X(%s%i),%s%i", hex, data, A, areg, D, dreg);
+					} else {
+						/* data reg -> mem */
+						textf(operand_s, "%s%i,%s%04X(%s%i)", D, dreg, hex, data, A, areg);
+					}
+					decoded = true;
+				} break;
+				case 51 : { /* MOVEQ */
+					const int dreg = (word & 0x0E00) >> 9;
+					inst.size = SizeLong;
+					operand(0, ModeQuick, 0, uint32_t(int32_t(int8_t(word & 0x00FF)))); /* sign extended */
+					operand(1, ModeDataRegister, dreg, 0);
+					mnemonicf(opcode_s, "MOVEQ");
+					textf(operand_s, "#%s%02X,%s%i", hex, (word & 0x00FF), D, dreg);
+					decoded = true;
+				} break;
+				case 54 : /* NBCD */
+				case 55 :
+				case 56 :
+				case 58 : { /* NEG, NEGX + NOT */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+					if (size == 3) break;
+
+					switch(opnum) {
+						case 54 : mnemonicf(opcode_s, "NBCD.%c", size_arr[size]);
+							break;
+						case 55 : mnemonicf(opcode_s, "NEG.%c", size_arr[size]);
+							break;
+						case 56 : mnemonicf(opcode_s, "NEGX.%c", size_arr[size]);
+							break;
+						case 58 : mnemonicf(opcode_s, "NOT.%c", size_arr[size]);
+							break;
+					}
+					inst.size = uint8_t(size);
+					ea(0, dmode, dreg, size, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 57 :
+				case 62 :
+				case 71 :
+				case 72 :
+				case 73 :
+				case 76 :
+				case 85 : { /* NOP, RESET, RTE, RTR, RTS, STOP, TRAPV */
+					switch(opnum) {
+						case 57 : mnemonicf(opcode_s, "NOP");
+							break;
+						case 62 : mnemonicf(opcode_s, "RESET");
+							break;
+						case 71 : mnemonicf(opcode_s, "RTE");
+							inst.flow = FlowReturn;
+							break;
+						case 72 : mnemonicf(opcode_s, "RTR");
+							inst.flow = FlowReturn;
+							break;
+						case 73 : mnemonicf(opcode_s, "RTS");
+							inst.flow = FlowReturn;
+							break;
+						case 76 : mnemonicf(opcode_s, "STOP");
+							break;
+						case 85 : mnemonicf(opcode_s, "TRAPV");
+							inst.flow = FlowTrap;
+							break;
+					}
+					decoded = true;
+				} break;
+				case 61 : { /* PEA */
+					const int smode = getmode(word);
+					if (smode <= 1) break;
+					if ((smode == 3) || (smode == 4)) break;
+					if (smode >= 11) break;
+
+					mnemonicf(opcode_s, "PEA");
+					const int sreg = word & 0x0007;
+					inst.size = SizeLong;
+					ea(0, smode, sreg, 0, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 75 : {/* Scc */
+					const int dmode = getmode(word);
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+
+					const int dreg = word & 0x0007;
+					const int cc = (word & 0x0F00) >> 8;
+
+					mnemonicf(opcode_s, "%s", scc_tab[cc]);
+					inst.size = SizeByte;
+					inst.condition = uint8_t(cc);
+					char dest_s[kMaxOperandText];
+					ea(0, dmode, dreg, 0, dest_s, sizeof(dest_s));
+					textf(operand_s, "%s", dest_s);
+					decoded = true;
+				} break;
+				case 82 : {/* SWAP */
+					const int dreg = word & 0x0007;
+					inst.size = SizeWord;
+					operand(0, ModeDataRegister, dreg, 0);
+					mnemonicf(opcode_s, "SWAP");
+					textf(operand_s, "%s%i", D, dreg);
+					decoded = true;
+				} break;
+				case 83 : { /* TAS */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+
+					inst.size = SizeByte;
+					mnemonicf(opcode_s, "TAS");
+					ea(0, dmode, dreg, 0, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 84 : { /* TRAP */
+					const int dreg = word & 0x000F;
+					inst.flow = FlowTrap;
+					operand(0, ModeQuick, 0, dreg);
+					mnemonicf(opcode_s, "TRAP");
+					textf(operand_s, "#%i", dreg);
+					decoded = true;
+				} break;
+				case 86 : { /* TST */
+					const int dmode = getmode(word);
+					const int dreg = word & 0x0007;
+					const int size = (word & 0x00C0) >> 6;
+
+					if (dmode == 1) break;
+					if (dmode >= 9) break;
+					if (size == 3) break;
+
+					inst.size = uint8_t(size);
+					mnemonicf(opcode_s, "TST.%c", size_arr[size]);
+					ea(0, dmode, dreg, size, operand_s, sizeof(operand_s));
+					decoded = true;
+				} break;
+				case 87 : {/* UNLK */
+					const int areg = word & 0x0007;
+					operand(0, ModeAddressRegister, areg, 0);
+					mnemonicf(opcode_s, "UNLK");
+					textf(operand_s, "%s%i", A, areg);
+					decoded = true;
+				} break;
+
+				default : printf("opnum out of range in switch (=%i)\n", opnum);
+					return false;
+			}
+			instrument_candidate(opnum, decoded);
+		}
+		if (decoded) break;
+	}
+
+	instrument_end(opnum, decoded, address - start_address);
+
+	if (!decoded) {
+		visitor.on_invalid(start_address, uint16_t(word));
+		return false;
+	}
+
+	inst.opnum = uint8_t(opnum);
+	inst.length = uint8_t(address - start_address);
+
+	visitor.on_instruction(inst);
+	for (int i = 0; i < inst.operand_count; ++i) {
+		visitor.on_operand(inst, i, inst.operands[i]);
+	}
+	if (inst.has_target) {
+		visitor.on_branch_target(inst, inst.target);
+	}
+	if (text) {
+		visitor.on_text(opcode_s, operand_s);
+	}
+	return true;
+}
+
+#undef diagnostic_printf
+#undef instrument_clock
+#undef instrument_begin
+#undef instrument_candidate
+#undef instrument_end
+
+#endif // DIS68K_DECODE_H
@@ -0,0 +1,67 @@
+/*	Normalised instruction and block hashes; see fingerprint.h. */
+
+#include <algorithm>
+
+#include "fingerprint.h"
+#include "parallel.h"
+
+uint64_t instruction_hash(const Dis68kInstruction &inst, unsigned int flags) {
+	uint64_t h = hash_combine(0, inst.opnum | (inst.size << 8) | (inst.condition << 16) | (inst.operand_count << 24));
+
+	for (unsigned int k = 0; k < inst.operand_count; ++k) {
+		const Dis68kOperand &op = inst.operands[k];
+		uint64_t value = op.mode;
+
+		switch (op.mode) {
+			case ModeDataRegister: case ModeAddressRegister:
+			case ModeIndirect: case ModePostIncrement: case ModePreDecrement:
+				if (!(flags & NormaliseRegisters)) value |= uint64_t(op.reg) << 8;
+				break;
+
+			case ModeDisplacement:
+			case ModeIndexed:
+				if (!(flags & NormaliseRegisters)) value |= uint64_t(op.reg) << 8 | uint64_t(op.index) << 16;
+				if (!(flags & NormaliseDisplacements)) value |= uint64_t(uint32_t(op.displacement)) << 32;
+				if (flags & NormaliseRegisters) value |= uint64_t(op.index & Dis68kOperand::IndexLong) << 16;
+				break;
+
+			case ModePCIndexed:
+				value |= uint64_t((flags & NormaliseRegisters) ? (op.index & Dis68kOperand::IndexLong) : op.index) << 16;
+				break;
+
+			case ModeImmediate:
+			case ModeQuick:
+				if (!(flags & NormaliseImmediates)) value |= uint64_t(op.value) << 32;
+				break;
+
+			case ModeRegisterList:
+				if (!(flags & NormaliseRegisters)) value |= uint64_t(op.value) << 32;
+				break;
+		}
+		h = hash_combine(h, value);
+	}
+	return h;
+}
+
+void block_hashes(const void *begin, const void *end, uint32_t address, const Program &program, unsigned int flags, std::vector<uint64_t> &hashes, unsigned int threads) {
+	hashes.resize(program.blocks.size());
+
+	/* Blocks are small; hand them out in batches. */
+	const size_t batch = 256;
+	parallel_for((program.blocks.size() + batch - 1) / batch, threads, [&](size_t k) {
+		Dis68k dis(begin, end, address);
+		Dis68kInstruction inst;
+
+		const size_t last = std::min(program.blocks.size(), (k + 1) * batch);
+		for (size_t b = k * batch; b < last; ++b) {
+			const BasicBlock &block = program.blocks[b];
+			uint64_t h = 0;
+
+			dis.seek(block.start);
+			while (dis.tell() < block.end && dis.decode(inst)) {
+				h = hash_combine(h, instruction_hash(inst, flags));
+			}
+			hashes[b] = h;
+		}
+	});
+}
@@ -0,0 +1,44 @@
+#if !defined( FINGERPRINT_H )
+#define FINGERPRINT_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "analysis.h"
+#include "dis68k.h"
+
+/*!
+	What instruction_hash leaves out, beyond absolute addresses, PC-relative
+	addresses and branch targets, which are always left out so that code hashes
+	the same wherever it is placed.
+*/
+enum NormaliseFlags {
+	NormaliseDisplacements = 0x01,	// d(An) and d(An,Xn) displacements
+	NormaliseRegisters = 0x02,		// register numbers, including MOVEM lists
+	NormaliseImmediates = 0x04		// immediate and quick data
+};
+
+/// Mixes @c value into the running hash @c h.
+inline uint64_t hash_combine(uint64_t h, uint64_t value)
+{
+	/* The splitmix64 finaliser, applied to the sum. */
+	uint64_t x = h + 0x9e3779b97f4a7c15ull + value;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+
+/// @returns A hash of @c inst with the parts selected by @c flags, a set of NormaliseFlags, left out.
+uint64_t instruction_hash(const Dis68kInstruction &inst, unsigned int flags);
+
+/*!
+	Hashes every block of @c program, analysed from the image [@c begin, @c end)
+	located at @c address, into @c hashes in block order: the instruction_hash
+	of each of its instructions, in order. Blocks are hashed in parallel on
+	@c threads threads, or one per hardware thread if zero.
+*/
+void block_hashes(const void *begin, const void *end, uint32_t address, const Program &program, unsigned int flags, std::vector<uint64_t> &hashes, unsigned int threads = 0);
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,193 @@
+/*	Per-thread decoder counters, merged on demand; see instrument.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "instrument.h"
+
+namespace {
+
+/* Named as the decoder names them; "mem" marks the memory forms of shifts. */
+const char *const opcode_names[kOptabEntries] = {
+	"",				"ABCD",			"ADD",			"ADDA",
+	"ADDI",			"ADDQ",			"ADDX",			"AND",
+	"ANDI",			"ASL",			"ASL mem",		"ASR",
+	"ASR mem",		"Bcc",			"BCHG Dn",		"BCHG #",
+	"BCLR Dn",		"BCLR #",		"BSET Dn",		"BSET #",
+	"BTST Dn",		"BTST #",		"CHK",			"CLR",
+	"CMP",			"CMPA",			"CMPI",			"CMPM",
+	"DBcc",			"DIVS",			"DIVU",			"EOR",
+	"EORI",			"EXG",			"EXT",			"JMP",
+	"JSR",			"LEA",			"LINK",			"LSL",
+	"LSL mem",		"LSR",			"LSR mem",		"MOVE",
+	"MOVE to CCR",	"MOVE to SR",	"MOVE from SR",	"MOVE USP",
+	"MOVEA",		"MOVEM",		"MOVEP",		"MOVEQ",
+	"MULS",			"MULU",			"NBCD",			"NEG",
+	"NEGX",			"NOP",			"NOT",			"OR",
+	"ORI",			"PEA",			"RESET",		"ROR",
+	"ROR mem",		"ROL",			"ROL mem",		"ROXL",
+	"ROXL mem",		"ROXR",			"ROXR mem",		"RTE",
+	"RTR",			"RTS",			"SBCD",			"Scc",
+	"STOP",			"SUB",			"SUBA",			"SUBI",
+	"SUBQ",			"SUBX",			"SWAP",			"TAS",
+	"TRAP",			"TRAPV",		"TST",			"UNLK"
+};
+
+const char *const class_names[InstructionClassCount] = {
+	"arithmetic", "logical", "shift", "bit", "move", "compare", "branch", "system", "undecoded"
+};
+
+const uint8_t opcode_classes[kOptabEntries] = {
+	ClassUndecoded,
+	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	/* 1..4 ABCD ADD ADDA ADDI */
+	ClassArithmetic,	ClassArithmetic,	ClassLogical,		ClassLogical,		/* 5..8 ADDQ ADDX AND ANDI */
+	ClassShift,			ClassShift,			ClassShift,			ClassShift,			/* 9..12 ASL ASR */
+	ClassBranch,		ClassBit,			ClassBit,			ClassBit,			/* 13..16 Bcc BCHG BCLR */
+	ClassBit,			ClassBit,			ClassBit,			ClassBit,			/* 17..20 BCLR BSET BTST */
+	ClassBit,			ClassSystem,		ClassMove,			ClassCompare,		/* 21..24 BTST CHK CLR CMP */
+	ClassCompare,		ClassCompare,		ClassCompare,		ClassBranch,		/* 25..28 CMPA CMPI CMPM DBcc */
+	ClassArithmetic,	ClassArithmetic,	ClassLogical,		ClassLogical,		/* 29..32 DIVS DIVU EOR EORI */
+	ClassMove,			ClassArithmetic,	ClassBranch,		ClassBranch,		/* 33..36 EXG EXT JMP JSR */
+	ClassMove,			ClassSystem,		ClassShift,			ClassShift,			/* 37..40 LEA LINK LSL */
+	ClassShift,			ClassShift,			ClassMove,			ClassSystem,		/* 41..44 LSR MOVE MOVE>CCR */
+	ClassSystem,		ClassSystem,		ClassSystem,		ClassMove,			/* 45..48 MOVE>SR SR> USP MOVEA */
+	ClassMove,			ClassMove,			ClassMove,			ClassArithmetic,	/* 49..52 MOVEM MOVEP MOVEQ MULS */
+	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	/* 53..56 MULU NBCD NEG NEGX */
+	ClassSystem,		ClassLogical,		ClassLogical,		ClassLogical,		/* 57..60 NOP NOT OR ORI */
+	ClassMove,			ClassSystem,		ClassShift,			ClassShift,			/* 61..64 PEA RESET ROR */
+	ClassShift,			ClassShift,			ClassShift,			ClassShift,			/* 65..68 ROL ROXL */
+	ClassShift,			ClassShift,			ClassBranch,		ClassBranch,		/* 69..72 ROXR RTE RTR */
+	ClassBranch,		ClassArithmetic,	ClassCompare,		ClassSystem,		/* 73..76 RTS SBCD Scc STOP */
+	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	ClassArithmetic,	/* 77..80 SUB SUBA SUBI SUBQ */
+	ClassArithmetic,	ClassMove,			ClassBit,			ClassSystem,		/* 81..84 SUBX SWAP TAS TRAP */
+	ClassSystem,		ClassCompare,		ClassSystem							/* 85..87 TRAPV TST UNLK */
+};
+
+/* Counters of live threads, plus the folded-in totals of threads that have exited. */
+struct Registry {
+	std::mutex mutex;
+	std::vector<Dis68kCounters *> live;
+	Dis68kCounters retired;
+	const char *dump_path;
+};
+
+Registry &registry() {
+	/* Deliberately never destroyed, so threads may retire during exit. */
+	static Registry *r = new Registry();
+	return *r;
+}
+
+struct ThreadCounters {
+	Dis68kCounters counters;
+
+	ThreadCounters() : counters() {
+		Registry &r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.live.push_back(&counters);
+	}
+
+	~ThreadCounters() {
+		Registry &r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.retired.merge(counters);
+		r.live.erase(std::find(r.live.begin(), r.live.end(), &counters));
+	}
+};
+
+void dump_at_exit() {
+	FILE *out = stderr;
+	const char *path = registry().dump_path;
+	if (path) {
+		out = fopen(path, "w");
+		if (!out) {
+			fprintf(stderr, "Couldn't open %s for instrumentation output\n", path);
+			return;
+		}
+	}
+	instrument_write_json(out);
+	if (path) fclose(out);
+}
+
+}
+
+void Dis68kCounters::merge(const Dis68kCounters &rhs) {
+	for (int i = 0; i < kOptabEntries; ++i) {
+		hits[i] += rhs.hits[i];
+		failed[i] += rhs.failed[i];
+	}
+	instructions += rhs.instructions;
+	undecoded += rhs.undecoded;
+	bytes += rhs.bytes;
+	for (int c = 0; c < InstructionClassCount; ++c) {
+		for (int b = 0; b < kCycleBuckets; ++b) {
+			cycles[c][b] += rhs.cycles[c][b];
+		}
+	}
+}
+
+InstructionClass instruction_class(int opnum) {
+	if (opnum <= 0 || opnum >= kOptabEntries) return ClassUndecoded;
+	return InstructionClass(opcode_classes[opnum]);
+}
+
+Dis68kCounters &instrument_counters() {
+	thread_local ThreadCounters local;
+	return local.counters;
+}
+
+void instrument_snapshot(Dis68kCounters *out) {
+	Registry &r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	*out = r.retired;
+	for (const Dis68kCounters *counters : r.live) {
+		out->merge(*counters);
+	}
+}
+
+void instrument_write_json(FILE *out) {
+	Dis68kCounters *totals = new Dis68kCounters();
+	instrument_snapshot(totals);
+
+	fprintf(out, "{\n\t\"instructions\": %llu,\n\t\"undecoded\": %llu,\n\t\"bytes\": %llu,\n\t\"opcodes\": [",
+		(unsigned long long)totals->instructions, (unsigned long long)totals->undecoded, (unsigned long long)totals->bytes);
+
+	bool first = true;
+	for (int opnum = 1; opnum < kOptabEntries; ++opnum) {
+		if (!totals->hits[opnum] && !totals->failed[opnum]) continue;
+		fprintf(out, "%s\n\t\t{\"opnum\": %i, \"name\": \"%s\", \"hits\": %llu, \"failed\": %llu}",
+			first ? "" : ",", opnum, opcode_names[opnum],
+			(unsigned long long)totals->hits[opnum], (unsigned long long)totals->failed[opnum]);
+		first = false;
+	}
+	fprintf(out, "\n\t],\n\t\"cycles\": {");
+
+	for (int c = 0; c < InstructionClassCount; ++c) {
+		/* Trim trailing empty buckets; bucket n counts [2^n, 2^(n+1)) cycles. */
+		int used = kCycleBuckets;
+		while (used && !totals->cycles[c][used - 1]) --used;
+
+		fprintf(out, "%s\n\t\t\"%s\": [", c ? "," : "", class_names[c]);
+		for (int b = 0; b < used; ++b) {
+			fprintf(out, "%s%llu", b ? ", " : "", (unsigned long long)totals->cycles[c][b]);
+		}
+		fprintf(out, "]");
+	}
+	fprintf(out, "\n\t}\n}\n");
+
+	delete totals;
+}
+
+void instrument_dump_at_exit(const char *path) {
+	Registry &r = registry();
+	{
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.dump_path = path;
+	}
+	static const bool registered = (atexit(dump_at_exit) == 0);
+	(void)registered;
+}
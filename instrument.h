@@ -0,0 +1,78 @@
+#if !defined( INSTRUMENT_H )
+#define INSTRUMENT_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+	Decoder instrumentation.
+
+	Build with DIS68K_INSTRUMENT defined to count, per thread, how often each
+	optab entry decodes an instruction or is rejected after its mask/value
+	matched, plus instruction and byte totals. Additionally define
+	DIS68K_INSTRUMENT_CYCLES to keep log2 histograms of timestamp-counter
+	cycles per decode, bucketed by instruction class. Without
+	DIS68K_INSTRUMENT the hooks, which are private to dis68k_decode.h,
+	compile to nothing.
+*/
+
+enum InstructionClass {
+	ClassArithmetic,
+	ClassLogical,
+	ClassShift,
+	ClassBit,
+	ClassMove,
+	ClassCompare,
+	ClassBranch,
+	ClassSystem,
+	ClassUndecoded,
+
+	InstructionClassCount
+};
+
+const int kOptabEntries = 88;
+const int kCycleBuckets = 32;
+
+struct Dis68kCounters {
+	uint64_t hits[kOptabEntries];		// instructions decoded by each optab entry
+	uint64_t failed[kOptabEntries];		// mask/value matched but the entry rejected the word
+	uint64_t instructions;
+	uint64_t undecoded;
+	uint64_t bytes;						// bytes consumed, decoded or not
+	uint64_t cycles[InstructionClassCount][kCycleBuckets];	// bucket n counts decodes of [2^n, 2^(n+1)) cycles
+
+	void merge(const Dis68kCounters &rhs);
+};
+
+/// @returns The instruction class of optab entry @c opnum.
+InstructionClass instruction_class(int opnum);
+
+/// @returns The calling thread's counters.
+Dis68kCounters &instrument_counters();
+
+/// Merges the counters of all live and exited threads into @c out.
+void instrument_snapshot(Dis68kCounters *out);
+
+/// Writes merged counters to @c out as JSON.
+void instrument_write_json(FILE *out);
+
+/// Arranges for merged counters to be written as JSON to @c path, or to stderr if @c path is null, at exit.
+void instrument_dump_at_exit(const char *path);
+
+/// Adds @c elapsed cycles to the histogram of @c cls; the decoder's hooks call this.
+inline void instrument_record_cycles(Dis68kCounters &counters, InstructionClass cls, uint64_t elapsed)
+{
+#if defined( DIS68K_INSTRUMENT_CYCLES )
+	int bucket = 0;
+	while( elapsed > 1 && bucket < kCycleBuckets - 1 )
+	{
+		elapsed >>= 1;
+		++bucket;
+	}
+	++counters.cycles[cls][bucket];
+#else
+	(void)counters; (void)cls; (void)elapsed;
+#endif
+}
+
+#endif // INSTRUMENT_H
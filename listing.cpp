@@ -0,0 +1,206 @@
+/*	Sequential and parallel listing output; see listing.h. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "listing.h"
+#include "parallel.h"
+
+namespace {
+
+const uint32_t min_chunk_size = 1 << 16;
+
+/* An instruction found while measuring a chunk, and the text that precedes it within the chunk. */
+struct Boundary {
+	uint32_t offset;
+	uint32_t bytes_before;
+};
+
+struct Chunk {
+	uint32_t begin, end;				// nominal extent, as offsets into the image
+	std::vector<Boundary> boundaries;	// as decoded from begin
+	uint32_t decoded_end;				// offset after the last instruction decoded from begin
+	uint32_t decoded_bytes;				// length of that text
+
+	uint32_t start;						// first offset of the true instruction stream in this chunk
+	uint64_t bytes;						// length of the true text of this chunk
+	uint64_t output_offset;
+};
+
+bool write_all(int fd, const char *data, size_t size) {
+	while (size) {
+		const ssize_t wrote = write(fd, data, size);
+		if (wrote < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		data += wrote;
+		size -= size_t(wrote);
+	}
+	return true;
+}
+
+template<typename Syntax>
+bool write_listing_parallel(const uint8_t *begin, const uint8_t *end, uint32_t address, int out_fd, unsigned int threads) {
+	const uint32_t size = uint32_t(end - begin);
+	const unsigned int workers = worker_count(threads);
+
+	/* Several chunks per worker smooths out uneven decoding cost. */
+	uint32_t chunk_size = std::max(min_chunk_size, (size / (workers * 4) + 1) & ~1u);
+	const size_t chunk_count = size ? (size + chunk_size - 1) / chunk_size : 0;
+	std::vector<Chunk> chunks(chunk_count);
+	for (size_t k = 0; k < chunk_count; ++k) {
+		chunks[k].begin = uint32_t(k * chunk_size);
+		chunks[k].end = std::min(size, uint32_t((k + 1) * chunk_size));
+	}
+
+	/* Pass 1: decode each chunk from its nominal start, noting boundaries and text length. */
+	parallel_for(chunk_count, workers, [&](size_t k) {
+		Chunk &chunk = chunks[k];
+		Dis68k dis(begin, end, address);
+		dis.seek(address + chunk.begin);
+
+		char line[kMaxListingLine];
+		uint32_t offset = chunk.begin, bytes = 0;
+		chunk.boundaries.reserve((chunk.end - chunk.begin) / 3);
+		while (offset < chunk.end) {
+			chunk.boundaries.push_back(Boundary{offset, bytes});
+			bytes += uint32_t(listing_line<Syntax>(dis, line, sizeof(line)));
+			offset = dis.tell() - address;
+		}
+		chunk.decoded_end = offset;
+		chunk.decoded_bytes = bytes;
+	});
+
+	/*
+		Pass 2: resynchronise. The true stream enters each chunk where the previous
+		one's left off; decode from there until it meets a boundary found in pass 1,
+		after which the two streams are identical.
+	*/
+	uint32_t position = 0;
+	uint64_t output_size = 0;
+	for (Chunk &chunk : chunks) {
+		chunk.start = position;
+		chunk.output_offset = output_size;
+
+		if (position >= chunk.end) {
+			chunk.bytes = 0;
+			continue;
+		}
+
+		const auto match = std::lower_bound(chunk.boundaries.begin(), chunk.boundaries.end(), position,
+			[](const Boundary &b, uint32_t offset) { return b.offset < offset; });
+		if (match != chunk.boundaries.end() && match->offset == position) {
+			chunk.bytes = chunk.decoded_bytes - match->bytes_before;
+			position = chunk.decoded_end;
+		} else {
+			Dis68k dis(begin, end, address);
+			dis.seek(address + position);
+
+			char line[kMaxListingLine];
+			uint64_t bytes = 0;
+			auto next = match;
+			while (true) {
+				while (next != chunk.boundaries.end() && next->offset < position) ++next;
+				if (next != chunk.boundaries.end() && next->offset == position) {
+					bytes += chunk.decoded_bytes - next->bytes_before;
+					position = chunk.decoded_end;
+					break;
+				}
+				if (position >= chunk.end) break;
+
+				bytes += listing_line<Syntax>(dis, line, sizeof(line));
+				position = dis.tell() - address;
+			}
+			chunk.bytes = bytes;
+		}
+		output_size += chunk.bytes;
+
+		std::vector<Boundary>().swap(chunk.boundaries);
+	}
+
+	/* Pass 3: format each chunk again, straight into its slice of the output. */
+	const auto format_chunk = [&](size_t k, char *out) {
+		const Chunk &chunk = chunks[k];
+		const uint32_t stop = (k + 1 < chunk_count) ? chunks[k + 1].start : position;
+
+		Dis68k dis(begin, end, address);
+		dis.seek(address + chunk.start);
+
+		/* Lines go via a local buffer so that snprintf's terminator never lands in the next slice. */
+		char line[kMaxListingLine];
+		for (uint32_t offset = chunk.start; offset < stop; offset = dis.tell() - address) {
+			const size_t length = listing_line<Syntax>(dis, line, sizeof(line));
+			memcpy(out, line, length);
+			out += length;
+		}
+	};
+
+	struct stat st;
+	const off_t base = lseek(out_fd, 0, SEEK_CUR);
+	if (output_size && base >= 0 && fstat(out_fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		const off_t final_size = base + off_t(output_size);
+		if (st.st_size < final_size && ftruncate(out_fd, final_size) != 0) {
+			fprintf(stderr, "Couldn't extend output: %s\n", strerror(errno));
+			return false;
+		}
+
+		const off_t map_offset = base & ~off_t(sysconf(_SC_PAGESIZE) - 1);
+		const size_t map_size = size_t(final_size - map_offset);
+		void *map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, map_offset);
+		if (map != MAP_FAILED) {
+			char *const out = (char *)map + (base - map_offset);
+			parallel_for(chunk_count, workers, [&](size_t k) {
+				format_chunk(k, out + chunks[k].output_offset);
+			});
+			munmap(map, map_size);
+			lseek(out_fd, final_size, SEEK_SET);
+			return true;
+		}
+	}
+
+	/* Not a mappable file: format into per-chunk buffers, then write them in order. */
+	std::vector<std::vector<char>> buffers(chunk_count);
+	parallel_for(chunk_count, workers, [&](size_t k) {
+		buffers[k].resize(chunks[k].bytes);
+		format_chunk(k, buffers[k].data());
+	});
+	for (const std::vector<char> &buffer : buffers) {
+		if (!write_all(out_fd, buffer.data(), buffer.size())) {
+			fprintf(stderr, "Error writing output: %s\n", strerror(errno));
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+bool write_listing(const void *begin, const void *end, uint32_t address, FILE *out, OutputSyntax syntax) {
+	const uint32_t end_address = address + uint32_t((const uint8_t *)end - (const uint8_t *)begin);
+
+	return with_syntax(syntax, [&](auto policy) {
+		typedef decltype(policy) Syntax;
+
+		Dis68k dis(begin, end, address);
+		char line[kMaxListingLine];
+		while (dis.tell() - address < end_address - address) {
+			const size_t length = listing_line<Syntax>(dis, line, sizeof(line));
+			if (fwrite(line, 1, length, out) != length) return false;
+		}
+		return true;
+	});
+}
+
+bool write_listing_parallel(const void *begin, const void *end, uint32_t address, int out_fd, OutputSyntax syntax, unsigned int threads) {
+	return with_syntax(syntax, [&](auto policy) {
+		return write_listing_parallel<decltype(policy)>((const uint8_t *)begin, (const uint8_t *)end, address, out_fd, threads);
+	});
+}
@@ -0,0 +1,128 @@
+#if !defined( LISTING_H )
+#define LISTING_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dis68k.h"
+
+/// The longest line listing_line can produce, including its terminator.
+const size_t kMaxListingLine = 256;
+
+/// The most bytes a single instruction can occupy.
+const uint32_t kMaxInstructionBytes = 10;
+
+/*!
+	Prints one listing line for the instruction at @c dis's current address to
+	@c out_s: the address, a tab, then the instruction. Words that don't decode,
+	or instructions that run beyond the input, are listed as data, with
+	Syntax::data_word, and decoding resumes at the following word; a trailing
+	odd byte is listed with Syntax::data_byte.
+
+	@returns The length of the line, as snprintf would.
+*/
+template<typename Syntax, typename View>
+size_t listing_line(BasicDis68k<View> &dis, char *out_s, size_t out_sz)
+{
+	char decoded[kMaxListingLine - 10];
+	uint32_t address;
+
+	if( dis.template disasm<Syntax>(&address, decoded, sizeof(decoded)) && !dis.overflowed() )
+	{
+		return snprintf(out_s, out_sz, "%08x\t%s", address, decoded);
+	}
+
+	char data_s[12];
+	uint16_t word;
+	if( dis.peekword(address, word) )
+	{
+		snprintf(data_s, sizeof(data_s), "%s%04X", Syntax::hex, word);
+		format_line<Syntax>(decoded, sizeof(decoded), Syntax::data_word, data_s);
+		dis.seek(address + 2);
+	}
+	else
+	{
+		uint8_t byte = 0;
+		dis.peekbyte(address, byte);
+		snprintf(data_s, sizeof(data_s), "%s%02X", Syntax::hex, byte);
+		format_line<Syntax>(decoded, sizeof(decoded), Syntax::data_byte, data_s);
+		dis.seek(address + 1);
+	}
+	return snprintf(out_s, out_sz, "%08x\t%s", address, decoded);
+}
+
+/*!
+	Writes the listing of the image [@c begin, @c end), located at @c address,
+	to @c out. This is the sequential reference for every other listing writer.
+
+	@returns @c false on a write error.
+*/
+bool write_listing(const void *begin, const void *end, uint32_t address, FILE *out, OutputSyntax syntax = OutputSyntax::Motorola);
+
+/*!
+	Writes the listing of write_listing with annotations: the line of each
+	decoded instruction ends with whatever @c annotator.comment(inst, comment_s,
+	comment_sz) prints there, as a comment, and @c annotator.after<Syntax>(inst,
+	out) may then write lines of its own, composed in the @c Syntax policy.
+
+	@returns @c false on a write error, including one reported by @c after.
+*/
+template<typename Annotator>
+bool write_annotated_listing(const void *begin, const void *end, uint32_t address, FILE *out, OutputSyntax syntax, Annotator &annotator)
+{
+	const uint32_t end_address = address + uint32_t((const uint8_t *)end - (const uint8_t *)begin);
+
+	return with_syntax(syntax, [&](auto policy) {
+		typedef decltype(policy) Syntax;
+
+		struct RecordingVisitor: public TextVisitor<Syntax> {
+			RecordingVisitor(char *out_s, size_t out_sz) : TextVisitor<Syntax>(out_s, out_sz) {}
+			void on_instruction(const Dis68kInstruction &decoded) { inst = decoded; }
+			Dis68kInstruction inst;
+		};
+
+		BasicDis68k<ContiguousView> dis(begin, end, address);
+		char line[kMaxListingLine], text[kMaxListingLine - 10], comment[64];
+		while( dis.tell() - address < end_address - address )
+		{
+			const uint32_t at = dis.tell();
+			RecordingVisitor visitor(text, sizeof(text));
+
+			if( !dis.decode(visitor) || dis.overflowed() )
+			{
+				dis.seek(at);
+				const size_t length = listing_line<Syntax>(dis, line, sizeof(line));
+				if( fwrite(line, 1, length, out) != length ) return false;
+				continue;
+			}
+
+			/* The text ends in a newline; any comment goes before it. */
+			text[strcspn(text, "\n")] = 0;
+			const size_t length = annotator.comment(visitor.inst, comment, sizeof(comment)) ?
+				snprintf(line, sizeof(line), "%08x\t%s\t%s %s\n", at, text, Syntax::comment, comment) :
+				snprintf(line, sizeof(line), "%08x\t%s\n", at, text);
+			if( fwrite(line, 1, length, out) != length ) return false;
+			if( !annotator.template after<Syntax>(visitor.inst, out) ) return false;
+		}
+		return true;
+	});
+}
+
+/*!
+	Writes the same listing as write_listing to @c out_fd, formatting in
+	parallel across @c threads threads (0 for one per hardware thread).
+
+	Each chunk of the image is decoded once to find its instruction boundaries
+	and the length of its text; chunks are then resynchronised with the
+	instruction stream that precedes them and their output offsets prefix-summed,
+	so that every worker can format straight into its own slice of the output.
+	A regular file is extended and mapped for this; any other descriptor gets
+	per-chunk buffers written in order.
+
+	@returns @c false on an I/O error, which is reported to stderr.
+*/
+bool write_listing_parallel(const void *begin, const void *end, uint32_t address, int out_fd, OutputSyntax syntax = OutputSyntax::Motorola, unsigned int threads = 0);
+
+#endif // LISTING_H
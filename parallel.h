@@ -0,0 +1,39 @@
+#if !defined( PARALLEL_H )
+#define PARALLEL_H 1
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// @returns @c threads, or the number of hardware threads if @c threads is zero.
+inline unsigned int worker_count(unsigned int threads)
+{
+	if( threads ) return threads;
+	const unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware ? hardware : 1;
+}
+
+/*!
+	Calls @c f(i) for every @c i in [0, @c count), handing out indices
+	dynamically to @c threads threads, one per hardware thread if zero.
+	The calling thread is one of the workers.
+*/
+template<typename F>
+void parallel_for(size_t count, unsigned int threads, F &&f)
+{
+	std::atomic<size_t> next(0);
+	const auto work = [&] {
+		for( size_t i = next++; i < count; i = next++ ) f(i);
+	};
+
+	const size_t workers = std::min<size_t>(worker_count(threads), count);
+	std::vector<std::thread> pool;
+	for( size_t t = 1; t < workers; ++t ) pool.emplace_back(work);
+	work();
+	for( std::thread &thread : pool ) thread.join();
+}
+
+#endif // PARALLEL_H
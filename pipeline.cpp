@@ -0,0 +1,227 @@
+/*	Reader/decoder/writer pipeline; see pipeline.h. */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "listing.h"
+#include "pipeline.h"
+#include "ring.h"
+
+namespace {
+
+const size_t input_chunk = 1 << 20;
+const size_t output_block_size = 1 << 16;
+const size_t output_blocks = 64;
+const size_t max_gather = std::min<size_t>(IOV_MAX, output_blocks);
+
+/* Address space reserved for input that can't be mapped, e.g. a pipe. */
+const size_t max_streamed_input = size_t(1) << 32;
+
+/* Published by the reader: input up to end is present. */
+struct InputChunk {
+	size_t end;
+	bool last;
+	bool failed;
+};
+
+struct OutputBlock {
+	char data[output_block_size];
+	size_t used;
+};
+
+typedef SpscRing<InputChunk, 64> InputRing;
+typedef SpscRing<OutputBlock *, output_blocks> BlockRing;
+
+struct Input {
+	uint8_t *data = nullptr;
+	size_t mapped = 0;
+	bool is_file = false;
+	size_t file_size = 0;
+};
+
+/* Reader stage: faults mapped files in ahead of the decoder, or reads streams into reserved memory. */
+void read_input(int in_fd, const Input &input, InputRing &chunks) {
+	if (input.is_file) {
+		const long page = sysconf(_SC_PAGESIZE);
+		for (size_t offset = 0; offset < input.file_size; offset += input_chunk) {
+			const size_t end = std::min(input.file_size, offset + input_chunk);
+			madvise(input.data + offset, end - offset, MADV_WILLNEED);
+
+			volatile uint8_t sink = 0;
+			for (size_t p = offset; p < end; p += page) sink = sink + input.data[p];
+
+			chunks.push(InputChunk{end, end == input.file_size, false});
+		}
+		if (!input.file_size) chunks.push(InputChunk{0, true, false});
+		return;
+	}
+
+	size_t end = 0;
+	while (true) {
+		const size_t want = std::min(input_chunk, input.mapped - end);
+		const ssize_t got = want ? read(in_fd, input.data + end, want) : 0;
+		if (got < 0) {
+			if (errno == EINTR) continue;
+			fprintf(stderr, "Error reading input: %s\n", strerror(errno));
+			chunks.push(InputChunk{end, true, true});
+			return;
+		}
+		if (!got) {
+			if (!want) fprintf(stderr, "Input exceeds %zu bytes; truncated\n", input.mapped);
+			chunks.push(InputChunk{end, true, false});
+			return;
+		}
+		end += size_t(got);
+		chunks.push(InputChunk{end, false, false});
+	}
+}
+
+/* Writer stage: gathers filled blocks into writev calls, then recycles them. A null block ends output. */
+bool write_output(int out_fd, BlockRing &filled, BlockRing &empty) {
+	struct iovec iov[max_gather];
+	OutputBlock *blocks[max_gather];
+	bool ok = true, done = false;
+
+	while (!done) {
+		size_t count = 0;
+		blocks[count++] = filled.pop();
+		while (count < max_gather && filled.try_pop(blocks[count])) ++count;
+
+		if (!blocks[count - 1]) {
+			--count;
+			done = true;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			iov[i].iov_base = blocks[i]->data;
+			iov[i].iov_len = blocks[i]->used;
+		}
+
+		struct iovec *pending = iov;
+		size_t remaining = count;
+		while (ok && remaining) {
+			const ssize_t wrote = writev(out_fd, pending, int(remaining));
+			if (wrote < 0) {
+				if (errno == EINTR) continue;
+				fprintf(stderr, "Error writing output: %s\n", strerror(errno));
+				ok = false;
+				break;
+			}
+
+			/* Skip whatever was written, which may end part way through a block. */
+			size_t skip = size_t(wrote);
+			while (remaining && skip >= pending->iov_len) {
+				skip -= pending->iov_len;
+				++pending;
+				--remaining;
+			}
+			if (remaining) {
+				pending->iov_base = (char *)pending->iov_base + skip;
+				pending->iov_len -= skip;
+			}
+		}
+
+		/* Keep draining after an error so that the decoder never blocks. */
+		for (size_t i = 0; i < count; ++i) empty.push(blocks[i]);
+	}
+	return ok;
+}
+
+}
+
+bool run_pipeline(int in_fd, int out_fd, uint32_t address, OutputSyntax syntax) {
+	Input input;
+	struct stat st;
+	if (fstat(in_fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		input.is_file = true;
+		input.file_size = size_t(st.st_size);
+		input.mapped = input.file_size;
+		if (input.mapped) {
+			void *data = mmap(nullptr, input.mapped, PROT_READ, MAP_PRIVATE, in_fd, 0);
+			if (data == MAP_FAILED) {
+				fprintf(stderr, "Couldn't map input: %s\n", strerror(errno));
+				return false;
+			}
+			input.data = (uint8_t *)data;
+		}
+	} else {
+		input.mapped = max_streamed_input;
+		void *data = mmap(nullptr, input.mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (data == MAP_FAILED) {
+			fprintf(stderr, "Couldn't reserve input buffer: %s\n", strerror(errno));
+			return false;
+		}
+		input.data = (uint8_t *)data;
+	}
+
+	InputRing *chunks = new InputRing();
+	BlockRing *filled = new BlockRing();
+	BlockRing *empty = new BlockRing();
+	OutputBlock *blocks = new OutputBlock[output_blocks - 1];
+	for (size_t i = 0; i < output_blocks - 1; ++i) empty->push(&blocks[i]);
+
+	std::thread reader(read_input, in_fd, std::cref(input), std::ref(*chunks));
+	std::atomic<bool> write_ok(true);
+	std::thread writer([&] { write_ok = write_output(out_fd, *filled, *empty); });
+
+	bool read_ok = true;
+	with_syntax(syntax, [&](auto policy) {
+		typedef decltype(policy) Syntax;
+
+		uint32_t offset = 0;
+		size_t available = 0;
+		bool last = false;
+		OutputBlock *block = empty->pop();
+		block->used = 0;
+
+		while (!last) {
+			const InputChunk chunk = chunks->pop();
+			available = chunk.end;
+			last = chunk.last;
+			read_ok = !chunk.failed;
+
+			/* Until the final chunk, stop short of any instruction that might straddle the end of the input so far. */
+			const size_t limit = last ? available : (available > kMaxInstructionBytes ? available - kMaxInstructionBytes : 0);
+			if (offset >= limit) continue;
+
+			Dis68k dis(input.data, input.data + available, address);
+			dis.seek(address + offset);
+			while (offset < limit) {
+				if (output_block_size - block->used < kMaxListingLine) {
+					filled->push(block);
+					block = empty->pop();
+					block->used = 0;
+				}
+				block->used += listing_line<Syntax>(dis, block->data + block->used, output_block_size - block->used);
+				offset = dis.tell() - address;
+			}
+		}
+
+		if (block->used) {
+			filled->push(block);
+		} else {
+			empty->push(block);
+		}
+		filled->push(nullptr);
+	});
+
+	reader.join();
+	writer.join();
+
+	delete[] blocks;
+	delete empty;
+	delete filled;
+	delete chunks;
+	if (input.data) munmap(input.data, input.mapped);
+
+	return read_ok && write_ok;
+}
@@ -0,0 +1,21 @@
+#if !defined( PIPELINE_H )
+#define PIPELINE_H 1
+
+#include <stdint.h>
+
+#include "dis68k.h"
+
+/*!
+	Lists the whole of @c in_fd to @c out_fd, located at @c address, using three
+	threads: a reader, which maps or reads the input and publishes it in chunks;
+	the decoder, on the calling thread; and a writer, which gathers output
+	blocks into writev calls. Stages hand over through single-producer,
+	single-consumer rings, so I/O overlaps decoding.
+
+	Output is identical to write_listing's.
+
+	@returns @c false on an I/O error, which is reported to stderr.
+*/
+bool run_pipeline(int in_fd, int out_fd, uint32_t address, OutputSyntax syntax = OutputSyntax::Motorola);
+
+#endif // PIPELINE_H
@@ -0,0 +1,226 @@
+/*	Constant register tracking; see registers.h. */
+
+#include "registers.h"
+
+namespace {
+
+uint32_t size_mask(unsigned int size) {
+	switch (size) {
+		case SizeByte: return 0x000000ff;
+		case SizeWord: return 0x0000ffff;
+	}
+	return 0xffffffff;
+}
+
+uint32_t sign_extend(uint32_t value, unsigned int size) {
+	switch (size) {
+		case SizeByte: return uint32_t(int32_t(int8_t(value)));
+		case SizeWord: return uint32_t(int32_t(int16_t(value)));
+	}
+	return value;
+}
+
+/* Bytes moved by one access of @c size through (An)+ or -(An); A7 is kept even. */
+uint32_t step(unsigned int size, unsigned int reg) {
+	switch (size) {
+		case SizeByte: return reg == 7 ? 2 : 1;
+		case SizeWord: return 2;
+	}
+	return 4;
+}
+
+/* Register numbers for operands in register modes, otherwise -1. */
+int operand_register(const Dis68kOperand &op) {
+	switch (op.mode) {
+		case ModeDataRegister: return op.reg;
+		case ModeAddressRegister: return int(address_register(op.reg));
+	}
+	return -1;
+}
+
+/* @returns The value of a source operand, if it's immediate or a known register. */
+bool source_value(const RegisterState &state, const Dis68kOperand &op, uint32_t &value) {
+	switch (op.mode) {
+		case ModeImmediate:
+		case ModeQuick:
+			value = op.value;
+			return true;
+	}
+	const int reg = operand_register(op);
+	return reg >= 0 && state.get(unsigned(reg), value);
+}
+
+/* Writes @c result to @c reg as an operation of @c size would: whole address registers, only the low bits of data registers. */
+void write(RegisterState &state, unsigned int reg, uint32_t result, unsigned int size) {
+	if (reg >= 8) {
+		state.set(reg, sign_extend(result, size));
+		return;
+	}
+
+	const uint32_t mask = size_mask(size);
+	uint32_t old;
+	if (mask == 0xffffffff) {
+		state.set(reg, result);
+	} else if (state.get(reg, old)) {
+		state.set(reg, (old & ~mask) | (result & mask));
+	} else {
+		state.forget(reg);
+	}
+}
+
+/* Whether an instruction leaves its final operand unmodified. */
+bool reads_only(unsigned int opnum) {
+	switch (opnum) {
+		case OpCMP: case OpCMPA: case OpCMPI: case OpCMPM:
+		case OpTST: case OpBTSTRegister: case OpBTSTImmediate: case OpCHK:
+		case OpMOVEtoCCR: case OpMOVEtoSR: case OpPEA: case OpJMP: case OpJSR:
+			return true;
+	}
+	return false;
+}
+
+}
+
+bool effective_address(const RegisterState &state, const Dis68kOperand &op, unsigned int size, uint32_t &address) {
+	uint32_t base, index = 0;
+	switch (op.mode) {
+		case ModeIndirect:
+		case ModePostIncrement:
+			return state.get(address_register(op.reg), address);
+		case ModePreDecrement:
+			if (!state.get(address_register(op.reg), base)) return false;
+			address = base - step(size, op.reg);
+			return true;
+		case ModeDisplacement:
+			if (!state.get(address_register(op.reg), base)) return false;
+			address = base + uint32_t(op.displacement);
+			return true;
+		case ModeIndexed:
+		case ModePCIndexed:
+			if (op.mode == ModeIndexed) {
+				if (!state.get(address_register(op.reg), base)) return false;
+				base += uint32_t(op.displacement);
+			} else {
+				base = op.value;
+			}
+			if (!state.get(op.index & (Dis68kOperand::IndexAddressRegister | 7), index)) return false;
+			if (!(op.index & Dis68kOperand::IndexLong)) index = sign_extend(index, SizeWord);
+			address = base + index;
+			return true;
+		case ModeAbsoluteShort:
+		case ModeAbsoluteLong:
+		case ModePCDisplacement:
+			address = op.value;
+			return true;
+	}
+	return false;
+}
+
+void track_instruction(RegisterState &state, const Dis68kInstruction &inst) {
+	const Dis68kOperand *const ops = inst.operands;
+	const int last = inst.operand_count - 1;
+
+	/* Address register updates, which every other effect follows. */
+	for (int k = 0; k <= last; ++k) {
+		if (ops[k].mode != ModePostIncrement && ops[k].mode != ModePreDecrement) continue;
+		const unsigned int reg = address_register(ops[k].reg);
+		uint32_t value;
+		if (inst.opnum == OpMOVEM || !state.get(reg, value)) {
+			state.forget(reg);
+		} else if (ops[k].mode == ModePostIncrement) {
+			state.set(reg, value + step(inst.size, ops[k].reg));
+		} else {
+			state.set(reg, value - step(inst.size, ops[k].reg));
+		}
+	}
+
+	const int destination = last >= 0 ? operand_register(ops[last]) : -1;
+	uint32_t source, value, address;
+	switch (inst.opnum) {
+		case OpMOVEQ:
+			state.set(ops[1].reg, ops[0].value);
+			return;
+
+		case OpLEA:
+			if (effective_address(state, ops[0], SizeLong, address)) {
+				state.set(unsigned(destination), address);
+			} else {
+				state.forget(unsigned(destination));
+			}
+			return;
+
+		case OpMOVE:
+		case OpMOVEA:
+		case OpCLR:
+			if (destination < 0) return;
+			if (inst.opnum == OpCLR) {
+				write(state, unsigned(destination), 0, inst.size);
+			} else if (source_value(state, ops[0], source)) {
+				write(state, unsigned(destination), source, inst.size);
+			} else {
+				state.forget(unsigned(destination));
+			}
+			return;
+
+		case OpADD: case OpADDA: case OpADDI: case OpADDQ:
+		case OpSUB: case OpSUBA: case OpSUBI: case OpSUBQ: {
+			if (destination < 0) return;
+
+			/* Address registers take the whole result of a sign-extended source. */
+			const unsigned int size = destination >= 8 ? unsigned(SizeLong) : unsigned(inst.size);
+			if (source_value(state, ops[0], source) && state.get(unsigned(destination), value)) {
+				if (destination >= 8) source = sign_extend(source, inst.size);
+				const bool add = inst.opnum == OpADD || inst.opnum == OpADDA || inst.opnum == OpADDI || inst.opnum == OpADDQ;
+				write(state, unsigned(destination), add ? value + source : value - source, size);
+			} else {
+				state.forget(unsigned(destination));
+			}
+		} return;
+
+		case OpEXG: {
+			const int a = operand_register(ops[0]), b = operand_register(ops[1]);
+			uint32_t va, vb;
+			const bool ka = state.get(unsigned(a), va), kb = state.get(unsigned(b), vb);
+			if (kb) state.set(unsigned(a), vb); else state.forget(unsigned(a));
+			if (ka) state.set(unsigned(b), va); else state.forget(unsigned(b));
+		} return;
+
+		case OpSWAP:
+			if (state.get(unsigned(destination), value)) state.set(unsigned(destination), (value << 16) | (value >> 16));
+			return;
+
+		case OpEXT:
+			if (state.get(unsigned(destination), value)) {
+				write(state, unsigned(destination), sign_extend(value, inst.size == SizeLong ? unsigned(SizeWord) : unsigned(SizeByte)), inst.size);
+			}
+			return;
+
+		case OpDBcc:
+			state.forget(ops[0].reg);
+			return;
+
+		case OpLINK:
+		case OpUNLK:
+			state.forget(address_register(ops[0].reg));
+			state.forget(address_register(7));
+			return;
+
+		case OpBcc:
+		case OpTRAP:
+		case OpTRAPV:
+		case OpJSR:
+			if (inst.flow != FlowCall && inst.flow != FlowTrap) return;
+			state.forget(0);
+			state.forget(1);
+			state.forget(address_register(0));
+			state.forget(address_register(1));
+			return;
+	}
+
+	if (last < 0 || reads_only(inst.opnum)) return;
+	if (destination >= 0) {
+		state.forget(unsigned(destination));
+	} else if (ops[last].mode == ModeRegisterList) {
+		state.known &= uint16_t(~ops[last].value);
+	}
+}
@@ -0,0 +1,66 @@
+#if !defined( REGISTERS_H )
+#define REGISTERS_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dis68k.h"
+
+/*!
+	The registers whose values are known at some point in the code: D0 to D7 are
+	registers 0 to 7, A0 to A7 are 8 to 15. Fixed size, so that a pass can keep
+	one per block without allocating.
+*/
+struct RegisterState {
+	uint32_t value[16];
+	uint16_t known;		// bit n set if value[n] is valid
+
+	RegisterState() : known(0) {}
+
+	bool get(unsigned int reg, uint32_t &v) const {
+		if( !(known & (1u << reg)) ) return false;
+		v = value[reg];
+		return true;
+	}
+	void set(unsigned int reg, uint32_t v) {
+		value[reg] = v;
+		known |= uint16_t(1u << reg);
+	}
+	void forget(unsigned int reg) {
+		known &= uint16_t(~(1u << reg));
+	}
+	void forget_all() {
+		known = 0;
+	}
+
+	/// Keeps only the values that @c other knows to be the same.
+	void meet(const RegisterState &other) {
+		uint16_t common = known & other.known;
+		for( unsigned int reg = 0; reg < 16; ++reg ) {
+			if( (common & (1u << reg)) && value[reg] != other.value[reg] ) common &= uint16_t(~(1u << reg));
+		}
+		known = common;
+	}
+};
+
+/// The register that Dis68kOperand::reg names, for an address register mode.
+inline unsigned int address_register(unsigned int reg) { return 8 + reg; }
+
+/*!
+	Computes the address that @c op refers to, given @c state, for the memory
+	modes, PC-relative modes and absolute addresses.
+
+	@param size The OperandSize of the access, needed for -(An).
+	@returns @c false if the operand isn't in memory or depends on an unknown register.
+*/
+bool effective_address(const RegisterState &state, const Dis68kOperand &op, unsigned int size, uint32_t &address);
+
+/*!
+	Applies the effect of @c inst to @c state: constants loaded by MOVEQ, LEA,
+	MOVE and MOVEA, simple arithmetic on known values, address register updates
+	by (An)+ and -(An), and forgetting whatever else is written. Calls and traps
+	forget the scratch registers D0, D1, A0 and A1.
+*/
+void track_instruction(RegisterState &state, const Dis68kInstruction &inst);
+
+#endif // REGISTERS_H
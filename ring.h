@@ -0,0 +1,141 @@
+#if !defined( RING_H )
+#define RING_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*!
+	A bounded, lock-free ring buffer for exactly one producer thread and one
+	consumer thread. @c Capacity must be a power of two.
+
+	Each side caches the other's index so that it touches the shared cache line
+	only when the ring appears full or empty. A side that must wait, in push or
+	pop, yields a bounded number of times and then sleeps until the other side
+	makes progress, so that a stage stalled on I/O doesn't hold a core busy.
+*/
+template<typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert( Capacity && !( Capacity & ( Capacity - 1 ) ), "Capacity must be a power of two" );
+
+public:
+	SpscRing() : head(0), cached_tail(0), tail(0), cached_head(0), producer_waiting(false), consumer_waiting(false) {}
+
+	/// Producer side. @returns @c false if the ring is full.
+	bool try_push(const T &value)
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if( t - cached_head == Capacity )
+		{
+			cached_head = head.load(std::memory_order_acquire);
+			if( t - cached_head == Capacity ) return false;
+		}
+
+		slots[t & ( Capacity - 1 )] = value;
+		tail.store(t + 1, std::memory_order_release);
+		wake(consumer_waiting, not_empty);
+		return true;
+	}
+
+	/// Consumer side. @returns @c false if the ring is empty.
+	bool try_pop(T &value)
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		if( h == cached_tail )
+		{
+			cached_tail = tail.load(std::memory_order_acquire);
+			if( h == cached_tail ) return false;
+		}
+
+		value = slots[h & ( Capacity - 1 )];
+		head.store(h + 1, std::memory_order_release);
+		wake(producer_waiting, not_full);
+		return true;
+	}
+
+	/// Producer side; waits until there is space.
+	void push(const T &value)
+	{
+		for( unsigned int spins = 0; !try_push(value); ++spins )
+		{
+			if( spins < spin_limit )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			wait(producer_waiting, not_full, [this] {
+				return tail.load(std::memory_order_relaxed) - head.load() < Capacity;
+			});
+		}
+	}
+
+	/// Consumer side; waits until there is a value.
+	T pop()
+	{
+		T value;
+		for( unsigned int spins = 0; !try_pop(value); ++spins )
+		{
+			if( spins < spin_limit )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			wait(consumer_waiting, not_empty, [this] {
+				return tail.load() != head.load(std::memory_order_relaxed);
+			});
+		}
+		return value;
+	}
+
+private:
+	static const size_t cache_line = 64;
+	static const unsigned int spin_limit = 64;
+
+	/*
+		Sleeps on @c cv until @c ready. The flag is raised before @c ready is
+		tested, and wake tests the flag after its index store, both in the
+		single sequentially consistent order, so one or the other always sees
+		the other side's progress.
+	*/
+	template<typename Ready>
+	void wait(std::atomic<bool> &waiting, std::condition_variable &cv, Ready ready)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		waiting.store(true);
+		cv.wait(lock, ready);
+		waiting.store(false, std::memory_order_relaxed);
+	}
+
+	void wake(std::atomic<bool> &waiting, std::condition_variable &cv)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if( waiting.load(std::memory_order_relaxed) )
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			cv.notify_one();
+		}
+	}
+
+	// Consumer-owned.
+	alignas(cache_line) std::atomic<size_t> head;
+	size_t cached_tail;
+
+	// Producer-owned.
+	alignas(cache_line) std::atomic<size_t> tail;
+	size_t cached_head;
+
+	alignas(cache_line) T slots[Capacity];
+
+	// Shared, but touched only by a side about to sleep or one with a sleeper to wake.
+	alignas(cache_line) std::atomic<bool> producer_waiting;
+	std::atomic<bool> consumer_waiting;
+	std::mutex mutex;
+	std::condition_variable not_full, not_empty;
+};
+
+#endif // RING_H
@@ -0,0 +1,166 @@
+/*	Instruction pattern search; see search.h. */
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "listing.h"
+#include "parallel.h"
+#include "search.h"
+
+namespace {
+
+/* Bytes per parallel task; a multiple of the vector width. */
+const size_t slice_bytes = 256 * 1024;
+
+bool operand_matches(const Dis68kInstruction &inst, const OperandConstraint &constraint) {
+	if (constraint.operand >= inst.operand_count) return false;
+
+	const Dis68kOperand &op = inst.operands[constraint.operand];
+	if (constraint.modes && !(constraint.modes & mode_bit(OperandMode(op.mode)))) return false;
+	if ((constraint.flags & ConstrainRegister) && op.reg != constraint.reg) return false;
+	if ((constraint.flags & ConstrainValue) && ((op.value ^ constraint.value) & constraint.value_mask)) return false;
+	if ((constraint.flags & ConstrainDisplacement) && op.displacement != constraint.displacement) return false;
+	return true;
+}
+
+bool pattern_matches(const Dis68kInstruction &inst, const InstructionPattern &pattern) {
+	if (pattern.opnum != OpNone && inst.opnum != pattern.opnum) return false;
+	if (pattern.match_target && (!inst.has_target || inst.target != pattern.target)) return false;
+	for (unsigned int c = 0; c < pattern.constraint_count; ++c) {
+		if (!operand_matches(inst, pattern.constraints[c])) return false;
+	}
+	return true;
+}
+
+/* Decodes the instruction at @c address and records every pattern it matches. */
+void check_candidate(Dis68k &dis, uint32_t address, const std::vector<InstructionPattern> &patterns, uint16_t word, std::vector<PatternMatch> &matches) {
+	Dis68kInstruction inst;
+	bool decoded = false, valid = false;
+	for (uint32_t p = 0; p < patterns.size(); ++p) {
+		const InstructionPattern &pattern = patterns[p];
+		if ((word & pattern.mask) != pattern.value) continue;
+
+		if (!decoded) {
+			dis.seek(address);
+			valid = dis.decode(inst) && !dis.overflowed();
+			decoded = true;
+		}
+		if (!valid) return;
+		if (pattern_matches(inst, pattern)) matches.push_back(PatternMatch{address, p});
+	}
+}
+
+/*
+	Searches the words of [@c first, @c last), offsets into the image, for candidates.
+	@c first is even, as is @c last unless it is the end of the image.
+*/
+void search_slice(const uint8_t *data, size_t first, size_t last, uint32_t address, Dis68k &dis, const std::vector<InstructionPattern> &patterns, std::vector<PatternMatch> &matches) {
+	size_t offset = first;
+
+#if defined(__SSE2__)
+	/*
+		Each pattern's mask and value, byte-swapped so as to apply to big-endian
+		words loaded as they are. A 16-byte load covers eight words; a word is a
+		candidate if any pattern's masked compare passes on both of its bytes.
+	*/
+	struct Lanes {
+		__m128i mask, value;
+	};
+	std::vector<Lanes> lanes;
+	for (const InstructionPattern &pattern : patterns) {
+		lanes.push_back(Lanes{_mm_set1_epi16(short(__builtin_bswap16(pattern.mask))), _mm_set1_epi16(short(__builtin_bswap16(pattern.value)))});
+	}
+
+	for (; offset + 16 <= last; offset += 16) {
+		const __m128i words = _mm_loadu_si128((const __m128i *)(data + offset));
+		__m128i any = _mm_setzero_si128();
+		for (const Lanes &pattern : lanes) {
+			any = _mm_or_si128(any, _mm_cmpeq_epi16(_mm_and_si128(words, pattern.mask), pattern.value));
+		}
+
+		/* Two bits per word; take the low one of each. */
+		unsigned int hits = unsigned(_mm_movemask_epi8(any)) & 0x5555;
+		while (hits) {
+			const unsigned int byte = unsigned(__builtin_ctz(hits));
+			hits &= hits - 1;
+
+			const uint16_t word = uint16_t((data[offset + byte] << 8) | data[offset + byte + 1]);
+			check_candidate(dis, address + uint32_t(offset + byte), patterns, word, matches);
+		}
+	}
+#endif
+
+	for (; offset + 2 <= last; offset += 2) {
+		const uint16_t word = uint16_t((data[offset] << 8) | data[offset + 1]);
+		check_candidate(dis, address + uint32_t(offset), patterns, word, matches);
+	}
+}
+
+}
+
+InstructionPattern opcode_pattern(Opnum opnum) {
+	InstructionPattern pattern = {};
+	pattern.mask = dis68k_detail::optab[opnum].mask;
+	pattern.value = dis68k_detail::optab[opnum].value;
+	pattern.opnum = uint8_t(opnum);
+	return pattern;
+}
+
+InstructionPattern call_pattern(uint32_t target, bool jump, uint32_t address_mask) {
+	/* JSR or JMP, to xxx.W or xxx.L. */
+	InstructionPattern pattern = opcode_pattern(jump ? OpJMP : OpJSR);
+	pattern.mask = 0xfffe;
+	pattern.value = jump ? 0x4ef8 : 0x4eb8;
+	pattern.constraint_count = 1;
+	pattern.constraints[0] = OperandConstraint{0, ConstrainValue, 0, mode_bit(ModeAbsoluteShort) | mode_bit(ModeAbsoluteLong), target, address_mask, 0};
+	return pattern;
+}
+
+InstructionPattern store_pattern(uint32_t target, uint32_t address_mask) {
+	/* MOVE with a destination of mode 7 and register 0 or 1: xxx.W or xxx.L. */
+	InstructionPattern pattern = opcode_pattern(OpMOVE);
+	pattern.mask = 0xcdc0;
+	pattern.value = 0x01c0;
+	pattern.constraint_count = 1;
+	pattern.constraints[0] = OperandConstraint{1, ConstrainValue, 0, mode_bit(ModeAbsoluteShort) | mode_bit(ModeAbsoluteLong), target, address_mask, 0};
+	return pattern;
+}
+
+void find_patterns(const void *begin, const void *end, uint32_t address, const std::vector<InstructionPattern> &patterns, std::vector<PatternMatch> &matches, unsigned int threads) {
+	matches.clear();
+	const uint8_t *const data = (const uint8_t *)begin;
+	const size_t size = size_t((const uint8_t *)end - data);
+
+	/* Instructions start at even addresses. */
+	const size_t first = address & 1;
+	if (patterns.empty() || size < first + 2) return;
+
+	const size_t slices = (size - first + slice_bytes - 1) / slice_bytes;
+	std::vector<std::vector<PatternMatch>> found(slices);
+	parallel_for(slices, threads, [&](size_t k) {
+		Dis68k dis(begin, end, address);
+		const size_t start = first + k * slice_bytes;
+		search_slice(data, start, std::min(size, start + slice_bytes), address, dis, patterns, found[k]);
+	});
+
+	for (const std::vector<PatternMatch> &slice : found) matches.insert(matches.end(), slice.begin(), slice.end());
+}
+
+bool write_pattern_matches(const void *begin, const void *end, uint32_t address, const std::vector<PatternMatch> &matches, FILE *out, OutputSyntax syntax) {
+	return with_syntax(syntax, [&](auto policy) {
+		typedef decltype(policy) Syntax;
+
+		Dis68k dis(begin, end, address);
+		char line[kMaxListingLine];
+		for (const PatternMatch &match : matches) {
+			dis.seek(match.address);
+			listing_line<Syntax>(dis, line, sizeof(line));
+			line[strcspn(line, "\n")] = 0;
+			if (fprintf(out, "%s\t%s pattern %u\n", line, Syntax::comment, match.pattern) < 0) return false;
+		}
+		return true;
+	});
+}
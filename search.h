@@ -0,0 +1,93 @@
+#if !defined( SEARCH_H )
+#define SEARCH_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "dis68k.h"
+
+/// What an OperandConstraint requires beyond the addressing mode.
+enum ConstraintFlags {
+	ConstrainRegister = 0x01,		// Dis68kOperand::reg
+	ConstrainValue = 0x02,			// Dis68kOperand::value, under OperandConstraint::value_mask: an absolute or PC-relative address, or immediate data
+	ConstrainDisplacement = 0x04	// Dis68kOperand::displacement
+};
+
+/// @returns The bit for @c mode in OperandConstraint::modes.
+inline uint32_t mode_bit(OperandMode mode)
+{
+	return uint32_t(1) << mode;
+}
+
+/// A requirement of one decoded operand.
+struct OperandConstraint {
+	uint8_t operand;		// index into Dis68kInstruction::operands
+	uint8_t flags;			// ConstraintFlags
+	uint8_t reg;
+	uint32_t modes;			// mode_bit of each OperandMode allowed, or 0 for any
+	uint32_t value;
+	uint32_t value_mask;	// the bits of value compared; the 68000 ignores the top byte of an address
+	int32_t displacement;
+};
+
+const unsigned int kMaxPatternConstraints = 2;
+
+/*!
+	An instruction to search for. The first word is tested against @c mask and
+	@c value as the decoder tests optab entries; then the instruction is decoded,
+	and must be @c opnum, unless that is OpNone, and meet every constraint.
+*/
+struct InstructionPattern {
+	uint16_t mask, value;
+	uint8_t opnum;				// an Opnum, or OpNone for any
+	uint8_t constraint_count;
+	bool match_target;			// whether the branch target must be @c target
+	uint32_t target;
+	OperandConstraint constraints[kMaxPatternConstraints];
+};
+
+/// @returns A pattern matching every instance of @c opnum, with its optab mask and value and no constraints.
+InstructionPattern opcode_pattern(Opnum opnum);
+
+/*!
+	@returns A pattern matching JSR, or JMP if @c jump, to the absolute address
+		@c target, as compared under @c address_mask; so by default
+		@c JSR $8000.W matches a target of $FF8000.
+*/
+InstructionPattern call_pattern(uint32_t target, bool jump = false, uint32_t address_mask = 0x00ffffff);
+
+/// @returns A pattern matching MOVE of any size to the absolute address @c target, as compared under @c address_mask.
+InstructionPattern store_pattern(uint32_t target, uint32_t address_mask = 0x00ffffff);
+
+/// A place where a pattern matched.
+struct PatternMatch {
+	uint32_t address;
+	uint32_t pattern;		// index into the patterns searched for
+};
+
+/*!
+	Finds every word of the image [@c begin, @c end), located at @c address,
+	at which one of @c patterns decodes, and stores them in @c matches in
+	ascending order of address, then of pattern. Every word is a candidate,
+	not only those a listing would start an instruction at, so a match may lie
+	within the extension words of another instruction or in data.
+
+	First words are compared against all patterns' masks and values eight at a
+	time, with SSE2 where the compiler offers it, on the raw big-endian words;
+	only words that pass are decoded. The image is searched in parallel slices
+	on @c threads threads, or one per hardware thread if zero.
+*/
+void find_patterns(const void *begin, const void *end, uint32_t address, const std::vector<InstructionPattern> &patterns, std::vector<PatternMatch> &matches, unsigned int threads = 0);
+
+/*!
+	Prints the listing line of each of @c matches, as write_listing would
+	print the instruction, followed by the index of the pattern it matched.
+
+	@returns @c false on a write error.
+*/
+bool write_pattern_matches(const void *begin, const void *end, uint32_t address, const std::vector<PatternMatch> &matches, FILE *out, OutputSyntax syntax = OutputSyntax::Motorola);
+
+#endif // SEARCH_H
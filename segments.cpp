@@ -0,0 +1,70 @@
+/*	Sparse, paged address spaces; see segments.h. */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "segments.h"
+
+/* Shared by every unmapped directory entry. */
+SegmentedImage::Page SegmentedImage::empty_table[1u << SegmentedImage::table_bits] = {};
+
+SegmentedImage::SegmentedImage(uint32_t _address_mask) :
+	address_mask(_address_mask),
+	directory(new Page *[directory_size]) {
+	std::fill(&directory[0], &directory[directory_size], &empty_table[0]);
+}
+
+bool SegmentedImage::add_segment(const void *_begin, const void *_end, uint32_t _address) {
+	const uint8_t *const data = (const uint8_t *)_begin;
+	const uint32_t size = uint32_t((const uint8_t *)_end - data);
+	if (!size) return true;
+
+	const uint32_t address = _address & address_mask;
+	const uint32_t last = address + (size - 1);
+	if (last < address || (last & ~address_mask)) return false;
+
+	segment_list.push_back(Segment{address, size});
+
+	/* Map page by page; only the first and last pages can be partial. */
+	uint32_t cursor = address;
+	while (true) {
+		const uint32_t page_address = cursor & ~page_mask;
+		const uint32_t lo = cursor - page_address;
+		const uint32_t hi = std::min(last - page_address, uint32_t(page_mask)) + 1;
+
+		map_page(page_address, data + (cursor - address), uint16_t(lo), uint16_t(hi));
+
+		if (last - page_address <= page_mask) break;
+		cursor = page_address + page_mask + 1;
+	}
+	return true;
+}
+
+void SegmentedImage::map_page(uint32_t page_address, const uint8_t *data, uint16_t lo, uint16_t hi) {
+	Page *&table = directory[page_address >> directory_shift];
+	if (table == empty_table) {
+		tables.emplace_back(new Page[1u << table_bits]());
+		table = tables.back().get();
+	}
+
+	Page &page = table[(page_address >> page_bits) & table_mask];
+	if (page.lo >= page.hi || (lo <= page.lo && hi >= page.hi)) {
+		/* The page is empty or entirely replaced; point straight at the segment. */
+		page.data = data;
+		page.lo = lo;
+		page.hi = hi;
+		return;
+	}
+
+	/* Shared with an earlier segment: merge both into a private copy of the page. */
+	uint8_t *merged = new uint8_t[page_mask + 1]();
+	owned_pages.emplace_back(merged);
+
+	memcpy(&merged[page.lo], page.data, page.hi - page.lo);
+	memcpy(&merged[lo], data, hi - lo);
+
+	page.lo = std::min(page.lo, lo);
+	page.hi = std::max(page.hi, hi);
+	page.data = &merged[page.lo];
+}
@@ -0,0 +1,141 @@
+#if !defined( SEGMENTS_H )
+#define SEGMENTS_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <vector>
+
+/*!
+	A sparse address space assembled from any number of segments, e.g. the
+	banks of a cartridge or the regions of a RAM snapshot.
+
+	Addresses resolve through a two-level page table of 4 KB pages: a directory
+	indexed by the top 12 bits of the address, then a table of 256 pages. A
+	lookup is two loads and a range check, whatever the number of segments.
+	Unmapped directory entries share a table of empty pages, so there are no
+	null checks on the fetch path.
+
+	Segment data is not copied, except for pages shared by more than one segment;
+	it must outlive the image. Where segments overlap, the later one wins; any
+	gap of less than a page between two segments reads as zero.
+*/
+class SegmentedImage
+{
+public:
+	struct Segment {
+		uint32_t address;
+		uint32_t size;
+	};
+
+	/*!
+		@param _address_mask Applied to every address; the 68000 ignores the top byte.
+	*/
+	explicit SegmentedImage(uint32_t _address_mask = 0x00ffffff);
+
+	/*!
+		Maps [@c _begin, @c _end) to start at @c _address.
+
+		@returns @c false if the segment would extend beyond the address mask.
+	*/
+	bool add_segment(const void *_begin, const void *_end, uint32_t _address);
+
+	const std::vector<Segment> &segments() const
+	{
+		return segment_list;
+	}
+
+	bool contains(uint32_t address) const
+	{
+		const Page &p = page(address);
+		const uint32_t offset = address & page_mask;
+		return offset >= p.lo && offset < p.hi;
+	}
+
+	bool byte(uint32_t address, uint8_t &res) const
+	{
+		const Page &p = page(address);
+		const uint32_t offset = address & page_mask;
+		if( offset < p.lo || offset >= p.hi ) return false;
+
+		res = p.data[offset - p.lo];
+		return true;
+	}
+
+	bool word(uint32_t address, uint16_t &res) const
+	{
+		const Page &p = page(address);
+		const uint32_t offset = address & page_mask;
+		if( offset >= p.lo && offset + 1 < p.hi )
+		{
+			const uint8_t *d = &p.data[offset - p.lo];
+			res = uint16_t( (d[0] << 8) | d[1] );
+			return true;
+		}
+
+		// Either unmapped or straddling a page boundary.
+		uint8_t high, low;
+		if( !byte(address, high) || !byte(address + 1, low) ) return false;
+		res = uint16_t( (high << 8) | low );
+		return true;
+	}
+
+private:
+	static const int page_bits = 12;
+	static const int table_bits = 8;
+	static const uint32_t page_mask = (1u << page_bits) - 1;
+	static const uint32_t table_mask = (1u << table_bits) - 1;
+	static const int directory_shift = page_bits + table_bits;
+	static const uint32_t directory_size = 1u << (32 - directory_shift);
+
+	/// data[offset - lo] is the byte at page offset @c offset, for offsets in [lo, hi).
+	struct Page {
+		const uint8_t *data;
+		uint16_t lo;
+		uint16_t hi;
+	};
+
+	const Page &page(uint32_t address) const
+	{
+		address &= address_mask;
+		return directory[address >> directory_shift][(address >> page_bits) & table_mask];
+	}
+
+	static Page empty_table[];
+
+	void map_page(uint32_t page_address, const uint8_t *data, uint16_t lo, uint16_t hi);
+
+	uint32_t address_mask;
+	std::unique_ptr<Page *[]> directory;
+	std::vector<std::unique_ptr<Page[]>> tables;
+	std::vector<std::unique_ptr<uint8_t[]>> owned_pages;
+	std::vector<Segment> segment_list;
+};
+
+/// An input view onto a SegmentedImage, which must outlive it; see views.h.
+class SegmentedView
+{
+public:
+	explicit SegmentedView(const SegmentedImage &_image) : image(&_image) {}
+
+	bool contains(uint32_t address) const
+	{
+		return image->contains(address);
+	}
+
+	bool byte(uint32_t address, uint8_t &res) const
+	{
+		return image->byte(address, res);
+	}
+
+	bool word(uint32_t address, uint16_t &res) const
+	{
+		return image->word(address, res);
+	}
+
+private:
+	const SegmentedImage *image;
+};
+
+#endif // SEGMENTS_H
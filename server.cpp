@@ -0,0 +1,414 @@
+/*	The resident disassembler; see server.h. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "analysis.h"
+#include "listing.h"
+#include "parallel.h"
+#include "server.h"
+#include "symbols.h"
+#include "vectors.h"
+
+namespace {
+
+/* Blocking I/O, for clients. */
+bool receive_all(int fd, void *data, size_t length) {
+	uint8_t *next = (uint8_t *)data;
+	while (length) {
+		const ssize_t received = recv(fd, next, length, 0);
+		if (received < 0 && errno == EINTR) continue;
+		if (received <= 0) return false;
+		next += received;
+		length -= size_t(received);
+	}
+	return true;
+}
+
+bool send_all(int fd, struct iovec *parts, size_t count) {
+	while (count) {
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = parts;
+		message.msg_iovlen = count;
+
+		ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR) continue;
+		if (sent <= 0) return false;
+
+		/* Skip what went, which may end part way through a part. */
+		while (count && size_t(sent) >= parts->iov_len) {
+			sent -= ssize_t(parts->iov_len);
+			++parts, --count;
+		}
+		if (count) {
+			parts->iov_base = (uint8_t *)parts->iov_base + sent;
+			parts->iov_len -= size_t(sent);
+		}
+	}
+	return true;
+}
+
+}
+
+struct DisassemblyServer::Image {
+	const uint8_t *data;
+	size_t size;
+	uint32_t address;
+	SymbolTable symbols;
+	std::vector<uint64_t> starts;		// a bit per word: whether the listing has an instruction there
+
+	std::once_flag analysed;
+	Program program;
+	std::vector<uint32_t> blocks_by_start;	// indices into program.blocks
+
+	Image() : data(nullptr), size(0), address(0) {}
+	~Image() {
+		if (data) munmap((void *)data, size);
+	}
+
+	/* Walks the image as write_listing does, marking where each line starts. */
+	void find_starts() {
+		starts.assign((size / 2 + 1 + 63) / 64, 0);
+
+		Dis68k dis(data, data + size, address);
+		Dis68kInstruction inst;
+		for (size_t offset = 0; offset < size;) {
+			starts[offset >> 7] |= uint64_t(1) << ((offset >> 1) & 63);
+			dis.seek(address + uint32_t(offset));
+			if (dis.decode(inst) && !dis.overflowed()) {
+				offset += inst.length;
+			} else {
+				offset += (size - offset >= 2) ? 2 : 1;
+			}
+		}
+	}
+
+	/* @returns The offset of the listing line at or before @c offset. */
+	size_t line_at(size_t offset) const {
+		for (size_t word = offset >> 1;; --word) {
+			if (starts[word >> 6] & (uint64_t(1) << (word & 63))) return word << 1;
+			if (!word) return 0;
+		}
+	}
+
+	void analyse() {
+		std::call_once(analysed, [this] {
+			std::vector<ExceptionVector> vectors;
+			read_vector_table(data, data + size, address, vectors);
+			if (vectors.empty() || !analyse_program(data, data + size, address, vector_entry_points(vectors), program)) return;
+
+			blocks_by_start.resize(program.blocks.size());
+			for (uint32_t b = 0; b < blocks_by_start.size(); ++b) blocks_by_start[b] = b;
+			std::sort(blocks_by_start.begin(), blocks_by_start.end(), [&](uint32_t a, uint32_t b) {
+				return program.blocks[a].start < program.blocks[b].start || (program.blocks[a].start == program.blocks[b].start && a < b);
+			});
+		});
+	}
+};
+
+/* A client, between events: the part of its request read so far, or the part of its response still to send. */
+struct DisassemblyServer::Connection {
+	int fd;
+	ServerRequest request;
+	size_t received;
+	std::vector<char> output;		// a ServerResponse and its payload
+	size_t sent;
+
+	explicit Connection(int _fd) : fd(_fd), received(0), sent(0) {}
+
+	bool sending() const {
+		return sent < output.size();
+	}
+};
+
+DisassemblyServer::DisassemblyServer() : listen_fd(-1), epoll_fd(-1), stop_fd(-1) {}
+
+DisassemblyServer::~DisassemblyServer() {
+	for (Connection *connection : connections) {
+		close(connection->fd);
+		delete connection;
+	}
+	if (listen_fd >= 0) close(listen_fd);
+	if (epoll_fd >= 0) close(epoll_fd);
+	if (stop_fd >= 0) close(stop_fd);
+	if (!socket_path.empty()) unlink(socket_path.c_str());
+}
+
+long DisassemblyServer::add_image(const char *path, uint32_t address, const char *symbols_path) {
+	std::unique_ptr<Image> image(new Image);
+	if (symbols_path) {
+		if (!image->symbols.load(symbols_path)) return -1;
+	}
+	image->symbols.build();
+
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Couldn't open image %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	struct stat status;
+	if (fstat(fd, &status) < 0 || !status.st_size) {
+		fprintf(stderr, "Couldn't read image %s: %s\n", path, status.st_size ? strerror(errno) : "it is empty");
+		close(fd);
+		return -1;
+	}
+	void *const mapped = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map image %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	image->data = (const uint8_t *)mapped;
+	image->size = size_t(status.st_size);
+	image->address = address;
+	image->find_starts();
+	images.push_back(std::move(image));
+	return long(images.size() - 1);
+}
+
+bool DisassemblyServer::listen(const char *path) {
+	struct sockaddr_un name;
+	memset(&name, 0, sizeof(name));
+	name.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(name.sun_path)) {
+		fprintf(stderr, "Socket path %s is too long\n", path);
+		return false;
+	}
+	strcpy(name.sun_path, path);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (listen_fd < 0 || epoll_fd < 0 || stop_fd < 0) {
+		fprintf(stderr, "Couldn't create socket: %s\n", strerror(errno));
+		return false;
+	}
+
+	unlink(path);
+	if (bind(listen_fd, (struct sockaddr *)&name, sizeof(name)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0) {
+		fprintf(stderr, "Couldn't listen on %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	socket_path = path;
+
+	/*
+		Both stay armed: every thread sees a stop, and any thread may accept.
+		Their events carry the address of the member holding the descriptor,
+		where a client's carry its Connection.
+	*/
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = &listen_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+	event.data.ptr = &stop_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event);
+	return true;
+}
+
+void DisassemblyServer::serve(unsigned int threads) {
+	if (epoll_fd < 0) return;
+
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < worker_count(threads); ++t) pool.emplace_back([this] { work(); });
+	work();
+	for (std::thread &thread : pool) thread.join();
+}
+
+void DisassemblyServer::stop() {
+	const uint64_t one = 1;
+	if (stop_fd >= 0 && write(stop_fd, &one, sizeof(one)) < 0) {
+		/* Already signalled. */
+	}
+}
+
+void DisassemblyServer::work() {
+	struct epoll_event event;
+	for (;;) {
+		const int ready = epoll_wait(epoll_fd, &event, 1, -1);
+		if (ready < 0 && errno == EINTR) continue;
+		if (ready < 0) {
+			fprintf(stderr, "Couldn't wait for requests: %s\n", strerror(errno));
+			return;
+		}
+		if (event.data.ptr == &stop_fd) return;
+		if (event.data.ptr == &listen_fd) {
+			accept_client();
+			continue;
+		}
+
+		/* Take the client as far as its socket allows, then wait for whichever way it is stuck. */
+		Connection *const connection = (Connection *)event.data.ptr;
+		if (!advance(*connection)) {
+			close_connection(connection);
+			continue;
+		}
+		event.events = (connection->sending() ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) < 0) close_connection(connection);
+	}
+}
+
+void DisassemblyServer::accept_client() {
+	const int client = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (client < 0) return;		// another thread took it
+
+	Connection *const connection = new Connection(client);
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		connections.insert(connection);
+	}
+
+	struct epoll_event armed;
+	memset(&armed, 0, sizeof(armed));
+	armed.events = EPOLLIN | EPOLLONESHOT;
+	armed.data.ptr = connection;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client, &armed) < 0) close_connection(connection);
+}
+
+void DisassemblyServer::close_connection(Connection *connection) {
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		connections.erase(connection);
+	}
+	close(connection->fd);
+	delete connection;
+}
+
+/*
+	Sends what the socket takes of the response in progress, then reads and
+	answers requests until the socket has no more to give or no room to take.
+	@returns @c false if the client has gone or failed.
+*/
+bool DisassemblyServer::advance(Connection &connection) {
+	for (;;) {
+		if (connection.sending()) {
+			const ssize_t sent = send(connection.fd, connection.output.data() + connection.sent, connection.output.size() - connection.sent, MSG_NOSIGNAL);
+			if (sent < 0 && errno == EINTR) continue;
+			if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+			connection.sent += size_t(sent);
+			continue;
+		}
+
+		const ssize_t received = recv(connection.fd, (char *)&connection.request + connection.received, sizeof(connection.request) - connection.received, 0);
+		if (received < 0 && errno == EINTR) continue;
+		if (received < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+		if (!received) return false;
+		connection.received += size_t(received);
+		if (connection.received < sizeof(connection.request)) continue;
+
+		/* The payload goes straight after room for the response. */
+		ServerResponse response = {StatusOK, 0};
+		connection.output.assign(sizeof(response), 0);
+		respond(connection.request, response, connection.output);
+		response.length = uint32_t(connection.output.size() - sizeof(response));
+		memcpy(connection.output.data(), &response, sizeof(response));
+		connection.received = 0;
+		connection.sent = 0;
+	}
+}
+
+void DisassemblyServer::respond(const ServerRequest &request, ServerResponse &response, std::vector<char> &payload) {
+	if (request.image >= images.size()) {
+		response.status = StatusNoImage;
+		return;
+	}
+	Image &image = *images[request.image];
+	const uint32_t offset = request.address - image.address;
+	const bool inside = offset < image.size;
+
+	switch (request.type) {
+		case RequestImage: {
+			const ServerImageInfo info = {image.address, uint32_t(image.size), uint32_t(image.symbols.size())};
+			payload.insert(payload.end(), (const char *)&info, (const char *)(&info + 1));
+		} break;
+
+		case RequestListing: {
+			if (request.count > kMaxServerListing) {
+				response.status = StatusBadRequest;
+				return;
+			}
+			if (!inside) {
+				response.status = StatusNotFound;
+				return;
+			}
+
+			const uint32_t end_address = image.address + uint32_t(image.size);
+			with_syntax(OutputSyntax(request.syntax), [&](auto policy) {
+				typedef decltype(policy) Syntax;
+
+				Dis68k dis(image.data, image.data + image.size, image.address);
+				dis.seek(image.address + uint32_t(image.line_at(offset)));
+				char line[kMaxListingLine];
+				for (uint32_t n = 0; n < request.count && dis.tell() - image.address < end_address - image.address; ++n) {
+					size_t length;
+					if (image.symbols.size()) {
+						const char *const label = image.symbols.find(dis.tell());
+						if (label) {
+							payload.insert(payload.end(), label, label + strlen(label));
+							payload.push_back(':');
+							payload.push_back('\n');
+						}
+						length = symbolic_listing_line<Syntax>(dis, image.symbols, line, sizeof(line));
+					} else {
+						length = listing_line<Syntax>(dis, line, sizeof(line));
+					}
+					payload.insert(payload.end(), line, line + std::min(length, sizeof(line) - 1));
+				}
+			});
+		} break;
+
+		case RequestFunction: {
+			image.analyse();
+			const Program &program = image.program;
+			const auto after = std::upper_bound(image.blocks_by_start.begin(), image.blocks_by_start.end(), request.address, [&](uint32_t a, uint32_t b) {
+				return a < program.blocks[b].start;
+			});
+			if (after == image.blocks_by_start.begin() || request.address >= program.blocks[*(after - 1)].end) {
+				response.status = StatusNotFound;
+				return;
+			}
+
+			const BasicBlock &block = program.blocks[*(after - 1)];
+			const Function &function = program.functions[block.function];
+			const ServerFunctionInfo info = {function.entry, block.start, block.end, function.block_count, function.origin};
+			payload.insert(payload.end(), (const char *)&info, (const char *)(&info + 1));
+		} break;
+
+		case RequestSymbol: {
+			const char *const name = image.symbols.find(request.address);
+			if (!name) {
+				response.status = StatusNotFound;
+				return;
+			}
+			payload.insert(payload.end(), name, name + strlen(name));
+		} break;
+
+		default:
+			response.status = StatusBadRequest;
+			break;
+	}
+}
+
+bool server_call(int fd, const ServerRequest &request, ServerResponse &response, std::vector<char> &payload) {
+	struct iovec part = {(void *)&request, sizeof(request)};
+	if (!send_all(fd, &part, 1)) return false;
+	if (!receive_all(fd, &response, sizeof(response))) return false;
+
+	payload.resize(response.length);
+	return !response.length || receive_all(fd, payload.data(), payload.size());
+}
@@ -0,0 +1,139 @@
+#if !defined( SERVER_H )
+#define SERVER_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/*
+	The protocol: a client sends ServerRequests over a Unix-domain stream
+	socket and reads a ServerResponse, then its payload, for each, in order.
+	Everything is in host byte order; the socket is local.
+*/
+
+enum ServerRequestType {
+	RequestImage = 1,		// payload: a ServerImageInfo
+	RequestListing,			// payload: the text of up to @c count listing lines, from the instruction at or before @c address
+	RequestFunction,		// payload: a ServerFunctionInfo for the block containing @c address
+	RequestSymbol			// payload: the name of @c address, without a terminator
+};
+
+enum ServerStatus {
+	StatusOK = 0,
+	StatusBadRequest,		// unknown type, or a count over kMaxServerListing
+	StatusNoImage,			// no such image
+	StatusNotFound			// the address is outside the image, or in no block, or has no name
+};
+
+struct ServerRequest {
+	uint32_t type;			// a ServerRequestType
+	uint32_t image;			// as numbered by DisassemblyServer::add_image
+	uint32_t address;
+	uint32_t count;			// RequestListing: lines
+	uint32_t syntax;		// RequestListing: an OutputSyntax
+};
+
+struct ServerResponse {
+	uint32_t status;		// a ServerStatus
+	uint32_t length;		// bytes of payload that follow
+};
+
+struct ServerImageInfo {
+	uint32_t address, size;
+	uint32_t symbols;		// names loaded for it
+};
+
+struct ServerFunctionInfo {
+	uint32_t entry;
+	uint32_t block_start, block_end;
+	uint32_t block_count;	// of the function
+	uint32_t origin;		// FunctionOrigin flags
+};
+
+/// The most lines one RequestListing may ask for.
+const uint32_t kMaxServerListing = 4096;
+
+/*!
+	A resident disassembler, answering ServerRequests on a Unix-domain socket.
+
+	Images stay mapped for the life of the server. Each has its listing's
+	instruction boundaries found when it is added, so that a listing request
+	starts straight from the right instruction; functions are found by
+	analyse_program on the first request that needs them, and kept.
+
+	Connections are served by a fixed pool of threads sharing one epoll set.
+	Client sockets are non-blocking: each connection keeps what has arrived of
+	its request, and what is left to send of its response, between events,
+	and is armed for one event at a time, so that whichever thread is free
+	takes its next step, and a slow client never holds a thread.
+*/
+class DisassemblyServer
+{
+public:
+	DisassemblyServer();
+	DisassemblyServer(const DisassemblyServer &) = delete;
+	DisassemblyServer &operator=(const DisassemblyServer &) = delete;
+	~DisassemblyServer();
+
+	/*!
+		Maps the image at @c path, located at @c address, with names from the
+		symbol file at @c symbols_path if that is not null; see SymbolTable::load.
+		Images must all be added before serve is called.
+
+		@returns The image's number, or -1, having printed a diagnostic, if it can't be read.
+	*/
+	long add_image(const char *path, uint32_t address, const char *symbols_path = nullptr);
+
+	/*!
+		Creates a socket at @c socket_path, replacing any stale one, and listens on it.
+
+		@returns @c false, having printed a diagnostic, on failure.
+	*/
+	bool listen(const char *socket_path);
+
+	/*!
+		Serves requests on @c threads threads, one per hardware thread if zero,
+		the calling thread among them, until stop is called.
+	*/
+	void serve(unsigned int threads = 0);
+
+	/*!
+		Makes serve return as soon as each thread is done with the client it is
+		handling. Requests in progress are abandoned: responses not yet wholly
+		sent are dropped when the server is destroyed. Safe to call from a
+		signal handler.
+	*/
+	void stop();
+
+private:
+	struct Image;
+	struct Connection;
+
+	void work();
+	void accept_client();
+	bool advance(Connection &connection);
+	void close_connection(Connection *connection);
+	void respond(const ServerRequest &request, ServerResponse &response, std::vector<char> &payload);
+
+	std::vector<std::unique_ptr<Image>> images;
+	int listen_fd, epoll_fd, stop_fd;
+	std::string socket_path;
+
+	std::mutex connections_mutex;
+	std::unordered_set<Connection *> connections;	// open, for the destructor to close
+};
+
+/*!
+	Sends @c request on @c fd, a connection to a DisassemblyServer, and reads
+	the response and its payload.
+
+	@returns @c false if the connection fails.
+*/
+bool server_call(int fd, const ServerRequest &request, ServerResponse &response, std::vector<char> &payload);
+
+#endif // SERVER_H
@@ -0,0 +1,389 @@
+/*	Function similarity signatures and the on-disk index; see similarity.h. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "fingerprint.h"
+#include "parallel.h"
+#include "similarity.h"
+#include "vectors.h"
+
+/* The layout of an index file. Every section starts on an eight-byte boundary. */
+struct IndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;				// NormaliseFlags
+	uint32_t file_count, function_count;
+	uint64_t band_count;
+	uint64_t files, functions, signatures, bands, strings;	// offsets of each section
+	uint64_t strings_size;
+};
+
+struct IndexFile {
+	uint32_t path;				// offset into the strings
+	uint32_t address;
+	uint32_t size;
+	uint32_t first_function, function_count;
+};
+
+struct IndexBandEntry {
+	uint64_t key;				// hash of the band's number and rows
+	uint32_t function;
+	uint32_t band;
+};
+
+namespace {
+
+const char index_magic[8] = {'D', '6', '8', 'K', 'S', 'I', 'M', '\0'};
+const uint32_t index_version = 1;
+
+/* The kSignatureSize hash functions, each (a * x + b) >> 32 over a 64-bit shingle hash with a odd. */
+struct Permutations {
+	uint64_t a[kSignatureSize], b[kSignatureSize];
+
+	Permutations() {
+		for (unsigned int k = 0; k < kSignatureSize; ++k) {
+			a[k] = hash_combine(0x68000, 2 * k) | 1;
+			b[k] = hash_combine(0x68000, 2 * k + 1);
+		}
+	}
+};
+
+const Permutations permutations;
+
+uint64_t band_key(const uint32_t *minhash, unsigned int band) {
+	uint64_t h = hash_combine(0, band);
+	for (unsigned int r = 0; r < kSignatureRows; ++r) h = hash_combine(h, minhash[band * kSignatureRows + r]);
+	return h;
+}
+
+bool key_less(const IndexBandEntry &entry, uint64_t key) {
+	return entry.key < key;
+}
+
+/* Maps the whole of @c path read-only; @returns null, having printed a diagnostic, on failure. */
+const uint8_t *map_file(const char *path, const char *what, size_t &length) {
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Couldn't open %s %s: %s\n", what, path, strerror(errno));
+		return nullptr;
+	}
+
+	struct stat status;
+	if (fstat(fd, &status) < 0) {
+		fprintf(stderr, "Couldn't read %s %s: %s\n", what, path, strerror(errno));
+		close(fd);
+		return nullptr;
+	}
+	length = size_t(status.st_size);
+	if (!length) {
+		fprintf(stderr, "%s %s is empty\n", what, path);
+		close(fd);
+		return nullptr;
+	}
+
+	void *const mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map %s %s: %s\n", what, path, strerror(errno));
+		return nullptr;
+	}
+	return (const uint8_t *)mapped;
+}
+
+/* What indexing one image produces. */
+struct IndexedImage {
+	bool indexed;
+	uint32_t size;
+	std::vector<IndexedFunction> functions;
+	std::vector<FunctionSignature> signatures;
+};
+
+void index_image(const IndexSource &source, unsigned int flags, IndexedImage &image) {
+	image.indexed = false;
+
+	size_t length = 0;
+	const uint8_t *const data = map_file(source.path.c_str(), "image", length);
+	if (!data) return;
+	if (length > 0xffffffffu - source.address) {
+		fprintf(stderr, "Image %s extends past the end of the address space; ignored\n", source.path.c_str());
+		munmap((void *)data, length);
+		return;
+	}
+
+	std::vector<ExceptionVector> vectors;
+	read_vector_table(data, data + length, source.address, vectors);
+
+	/* Each image is analysed on the thread that loaded it; the parallelism is across images. */
+	Program program;
+	if (vectors.empty() || !analyse_program(data, data + length, source.address, vector_entry_points(vectors), program, 1)) {
+		fprintf(stderr, "Image %s has no usable exception vectors; ignored\n", source.path.c_str());
+		munmap((void *)data, length);
+		return;
+	}
+
+	FunctionSignature signature;
+	for (uint32_t f = 0; f < program.functions.size(); ++f) {
+		if (!function_signature(data, data + length, source.address, program, f, flags, signature)) continue;
+		image.functions.push_back(IndexedFunction{0, program.functions[f].entry, signature.instructions, program.functions[f].block_count});
+		image.signatures.push_back(signature);
+	}
+	image.size = uint32_t(length);
+	image.indexed = true;
+	munmap((void *)data, length);
+}
+
+uint64_t aligned(uint64_t offset) {
+	return (offset + 7) & ~uint64_t(7);
+}
+
+bool write_at(FILE *out, uint64_t offset, const void *data, size_t size) {
+	if (fseeko(out, off_t(offset), SEEK_SET) < 0) return false;
+	return !size || fwrite(data, size, 1, out) == 1;
+}
+
+}
+
+bool function_signature(const void *begin, const void *end, uint32_t address, const Program &program, uint32_t function, unsigned int flags, FunctionSignature &signature) {
+	thread_local std::vector<uint64_t> instructions, shingles;
+	shingles.clear();
+
+	const Function &f = program.functions[function];
+	Dis68k dis(begin, end, address);
+	Dis68kInstruction inst;
+	uint32_t count = 0;
+	for (uint32_t b = f.first_block; b < f.first_block + f.block_count; ++b) {
+		const BasicBlock &block = program.blocks[b];
+		instructions.clear();
+		dis.seek(block.start);
+		while (dis.tell() < block.end && dis.decode(inst)) instructions.push_back(instruction_hash(inst, flags));
+		count += uint32_t(instructions.size());
+
+		const size_t length = std::min<size_t>(kShingleLength, instructions.size());
+		for (size_t i = 0; i + length <= instructions.size() && length; ++i) {
+			uint64_t h = 0;
+			for (size_t j = i; j < i + length; ++j) h = hash_combine(h, instructions[j]);
+			shingles.push_back(h);
+		}
+	}
+	signature.instructions = count;
+	if (count < kMinSignatureInstructions) return false;
+
+	std::sort(shingles.begin(), shingles.end());
+	shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+
+	std::fill(signature.minhash, signature.minhash + kSignatureSize, 0xffffffffu);
+	for (uint64_t shingle : shingles) {
+		for (unsigned int k = 0; k < kSignatureSize; ++k) {
+			const uint32_t h = uint32_t((permutations.a[k] * shingle + permutations.b[k]) >> 32);
+			signature.minhash[k] = std::min(signature.minhash[k], h);
+		}
+	}
+	return true;
+}
+
+double signature_similarity(const FunctionSignature &a, const FunctionSignature &b) {
+	unsigned int equal = 0;
+	for (unsigned int k = 0; k < kSignatureSize; ++k) equal += a.minhash[k] == b.minhash[k];
+	return double(equal) / double(kSignatureSize);
+}
+
+bool build_similarity_index(const std::vector<IndexSource> &sources, const char *index_path, unsigned int flags, unsigned int threads) {
+	std::vector<IndexedImage> images(sources.size());
+	parallel_for(sources.size(), threads, [&](size_t k) {
+		index_image(sources[k], flags, images[k]);
+	});
+
+	/* Assemble the sections. */
+	std::vector<IndexFile> files;
+	std::vector<IndexedFunction> functions;
+	std::vector<uint32_t> signatures;
+	std::vector<char> strings;
+	for (size_t k = 0; k < sources.size(); ++k) {
+		const IndexedImage &image = images[k];
+		if (!image.indexed) continue;
+
+		const uint32_t file = uint32_t(files.size());
+		files.push_back(IndexFile{uint32_t(strings.size()), sources[k].address, image.size, uint32_t(functions.size()), uint32_t(image.functions.size())});
+		strings.insert(strings.end(), sources[k].path.begin(), sources[k].path.end());
+		strings.push_back('\0');
+
+		for (size_t f = 0; f < image.functions.size(); ++f) {
+			functions.push_back(image.functions[f]);
+			functions.back().file = file;
+			signatures.insert(signatures.end(), image.signatures[f].minhash, image.signatures[f].minhash + kSignatureSize);
+		}
+	}
+	images.clear();
+
+	std::vector<IndexBandEntry> bands(functions.size() * kSignatureBands);
+	parallel_for(functions.size(), threads, [&](size_t f) {
+		for (unsigned int band = 0; band < kSignatureBands; ++band) {
+			bands[f * kSignatureBands + band] = IndexBandEntry{band_key(&signatures[f * kSignatureSize], band), uint32_t(f), band};
+		}
+	});
+	std::sort(bands.begin(), bands.end(), [](const IndexBandEntry &a, const IndexBandEntry &b) {
+		return a.key < b.key || (a.key == b.key && a.function < b.function);
+	});
+
+	IndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, index_magic, sizeof(header.magic));
+	header.version = index_version;
+	header.flags = flags;
+	header.file_count = uint32_t(files.size());
+	header.function_count = uint32_t(functions.size());
+	header.band_count = bands.size();
+	header.files = aligned(sizeof(header));
+	header.functions = aligned(header.files + files.size() * sizeof(IndexFile));
+	header.signatures = aligned(header.functions + functions.size() * sizeof(IndexedFunction));
+	header.bands = aligned(header.signatures + signatures.size() * sizeof(uint32_t));
+	header.strings = aligned(header.bands + bands.size() * sizeof(IndexBandEntry));
+	header.strings_size = strings.size();
+
+	FILE *const out = fopen(index_path, "wb");
+	if (!out) {
+		fprintf(stderr, "Couldn't create index %s: %s\n", index_path, strerror(errno));
+		return false;
+	}
+	bool written = write_at(out, 0, &header, sizeof(header)) &&
+		write_at(out, header.files, files.data(), files.size() * sizeof(IndexFile)) &&
+		write_at(out, header.functions, functions.data(), functions.size() * sizeof(IndexedFunction)) &&
+		write_at(out, header.signatures, signatures.data(), signatures.size() * sizeof(uint32_t)) &&
+		write_at(out, header.bands, bands.data(), bands.size() * sizeof(IndexBandEntry)) &&
+		write_at(out, header.strings, strings.data(), strings.size());
+	written = (fclose(out) == 0) && written;
+	if (!written) {
+		fprintf(stderr, "Couldn't write index %s: %s\n", index_path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+SimilarityIndex::SimilarityIndex() :
+	mapped(nullptr), length(0), header(nullptr), files(nullptr), functions(nullptr), signatures(nullptr), bands(nullptr), strings(nullptr) {}
+
+SimilarityIndex::~SimilarityIndex() {
+	close();
+}
+
+bool SimilarityIndex::open(const char *path) {
+	close();
+
+	size_t size = 0;
+	const uint8_t *const data = map_file(path, "index", size);
+	if (!data) return false;
+
+	/* Check that every section lies within the file before trusting any of them. */
+	const IndexHeader *const h = (const IndexHeader *)data;
+	const auto within = [&](uint64_t offset, uint64_t count, uint64_t item) {
+		return offset % 8 == 0 && offset <= size && count <= (size - offset) / item;
+	};
+	if (size < sizeof(IndexHeader) || memcmp(h->magic, index_magic, sizeof(h->magic)) || h->version != index_version) {
+		fprintf(stderr, "%s isn't a similarity index of this version\n", path);
+		munmap((void *)data, size);
+		return false;
+	}
+	if (!within(h->files, h->file_count, sizeof(IndexFile)) ||
+		!within(h->functions, h->function_count, sizeof(IndexedFunction)) ||
+		!within(h->signatures, uint64_t(h->function_count) * kSignatureSize, sizeof(uint32_t)) ||
+		!within(h->bands, h->band_count, sizeof(IndexBandEntry)) ||
+		!within(h->strings, h->strings_size, 1) || (h->strings_size && data[h->strings + h->strings_size - 1])) {
+		fprintf(stderr, "Similarity index %s is truncated or corrupt\n", path);
+		munmap((void *)data, size);
+		return false;
+	}
+
+	mapped = data;
+	length = size;
+	header = h;
+	files = (const IndexFile *)(data + h->files);
+	functions = (const IndexedFunction *)(data + h->functions);
+	signatures = (const uint32_t *)(data + h->signatures);
+	bands = (const IndexBandEntry *)(data + h->bands);
+	strings = (const char *)(data + h->strings);
+	return true;
+}
+
+void SimilarityIndex::close() {
+	if (mapped) munmap((void *)mapped, length);
+	mapped = nullptr;
+	length = 0;
+	header = nullptr;
+	files = nullptr;
+	functions = nullptr;
+	signatures = nullptr;
+	bands = nullptr;
+	strings = nullptr;
+}
+
+unsigned int SimilarityIndex::flags() const {
+	return header ? header->flags : 0;
+}
+
+uint32_t SimilarityIndex::file_count() const {
+	return header ? header->file_count : 0;
+}
+
+uint32_t SimilarityIndex::function_count() const {
+	return header ? header->function_count : 0;
+}
+
+const char *SimilarityIndex::file_path(uint32_t file) const {
+	return strings + files[file].path;
+}
+
+uint32_t SimilarityIndex::file_address(uint32_t file) const {
+	return files[file].address;
+}
+
+const IndexedFunction &SimilarityIndex::function(uint32_t function) const {
+	return functions[function];
+}
+
+FunctionSignature SimilarityIndex::signature(uint32_t function) const {
+	FunctionSignature signature;
+	memcpy(signature.minhash, signatures + size_t(function) * kSignatureSize, sizeof(signature.minhash));
+	signature.instructions = functions[function].instructions;
+	return signature;
+}
+
+void SimilarityIndex::query(const FunctionSignature &signature, size_t count, double min_similarity, std::vector<SimilarityMatch> &matches) const {
+	matches.clear();
+	if (!header) return;
+
+	/* Candidates are the functions that agree with the query on every row of some band. */
+	std::vector<uint32_t> candidates;
+	const IndexBandEntry *const last = bands + header->band_count;
+	for (unsigned int band = 0; band < kSignatureBands; ++band) {
+		const uint64_t key = band_key(signature.minhash, band);
+		for (const IndexBandEntry *entry = std::lower_bound(bands, last, key, key_less); entry != last && entry->key == key; ++entry) {
+			if (entry->band == band) candidates.push_back(entry->function);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	for (uint32_t function : candidates) {
+		unsigned int equal = 0;
+		const uint32_t *const minhash = signatures + size_t(function) * kSignatureSize;
+		for (unsigned int k = 0; k < kSignatureSize; ++k) equal += signature.minhash[k] == minhash[k];
+
+		const double similarity = double(equal) / double(kSignatureSize);
+		if (similarity >= min_similarity) matches.push_back(SimilarityMatch{function, similarity});
+	}
+
+	const auto closer = [](const SimilarityMatch &a, const SimilarityMatch &b) {
+		return a.similarity > b.similarity || (a.similarity == b.similarity && a.function < b.function);
+	};
+	count = std::min(count, matches.size());
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), closer);
+	matches.resize(count);
+}
@@ -0,0 +1,130 @@
+#if !defined( SIMILARITY_H )
+#define SIMILARITY_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+
+/// Instructions per shingle: each function is described by the set of its runs of this many instructions.
+const unsigned int kShingleLength = 4;
+
+/// MinHash values per function signature, split into kSignatureBands bands for lookup.
+const unsigned int kSignatureSize = 64;
+const unsigned int kSignatureBands = 16;
+const unsigned int kSignatureRows = kSignatureSize / kSignatureBands;
+
+/// Functions shorter than this are too common to say anything, and aren't indexed.
+const unsigned int kMinSignatureInstructions = 8;
+
+/// The MinHash signature of one function.
+struct FunctionSignature {
+	uint32_t minhash[kSignatureSize];
+	uint32_t instructions;
+};
+
+/*!
+	Computes the signature of function @c function of @c program, analysed from
+	the image [@c begin, @c end) located at @c address. Each block's
+	instructions are hashed by instruction_hash with @c flags, a set of
+	NormaliseFlags, and every run of kShingleLength of them within a block, or
+	the whole of a shorter block, makes one shingle.
+
+	@returns @c false if the function has fewer than kMinSignatureInstructions instructions.
+*/
+bool function_signature(const void *begin, const void *end, uint32_t address, const Program &program, uint32_t function, unsigned int flags, FunctionSignature &signature);
+
+/// @returns The estimated Jaccard similarity of the shingle sets behind @c a and @c b: the share of equal MinHash values.
+double signature_similarity(const FunctionSignature &a, const FunctionSignature &b);
+
+/// An image to index.
+struct IndexSource {
+	std::string path;
+	uint32_t address;		// where the image is located
+};
+
+/*!
+	Indexes the functions of every image in @c sources, each analysed from its
+	exception vectors, and writes the index to @c index_path. Images are read
+	and analysed in parallel, one per thread, on @c threads threads or one per
+	hardware thread if zero. An image that can't be read or analysed is
+	reported and left out.
+
+	The index is a single flat file, in host byte order, that SimilarityIndex
+	maps as it is: a header, then the images, the functions, their signatures,
+	a table of each signature band's hash sorted for binary search, and the
+	image paths.
+
+	@returns @c false, having printed a diagnostic, if the index can't be written.
+*/
+bool build_similarity_index(const std::vector<IndexSource> &sources, const char *index_path, unsigned int flags = 0, unsigned int threads = 0);
+
+/// An indexed function, as stored.
+struct IndexedFunction {
+	uint32_t file;			// index of its image
+	uint32_t entry;
+	uint32_t instructions;
+	uint32_t blocks;
+};
+
+/// An indexed function similar to a query.
+struct SimilarityMatch {
+	uint32_t function;		// index into the index's functions
+	double similarity;		// estimated, from the signatures
+};
+
+struct IndexHeader;
+struct IndexFile;
+struct IndexBandEntry;
+
+/*!
+	A similarity index written by build_similarity_index, mapped read-only.
+	Queries look up each band of the query signature in the sorted band table,
+	so that only functions sharing a band with it are compared; at 16 bands of
+	4 rows, functions of similarity 0.5 are found about two times in three and
+	those of 0.7 almost always.
+*/
+class SimilarityIndex
+{
+public:
+	SimilarityIndex();
+	SimilarityIndex(const SimilarityIndex &) = delete;
+	SimilarityIndex &operator=(const SimilarityIndex &) = delete;
+	~SimilarityIndex();
+
+	/// @returns @c false, having printed a diagnostic, if @c path isn't a readable index.
+	bool open(const char *path);
+	void close();
+
+	/// @returns The NormaliseFlags the index was built with; queries should use the same.
+	unsigned int flags() const;
+
+	uint32_t file_count() const;
+	uint32_t function_count() const;
+	const char *file_path(uint32_t file) const;
+	uint32_t file_address(uint32_t file) const;
+	const IndexedFunction &function(uint32_t function) const;
+	FunctionSignature signature(uint32_t function) const;
+
+	/*!
+		Finds up to @c count indexed functions with an estimated similarity to
+		@c signature of at least @c min_similarity, most similar first, and
+		stores them in @c matches.
+	*/
+	void query(const FunctionSignature &signature, size_t count, double min_similarity, std::vector<SimilarityMatch> &matches) const;
+
+private:
+	const uint8_t *mapped;
+	size_t length;
+	const IndexHeader *header;
+	const IndexFile *files;
+	const IndexedFunction *functions;
+	const uint32_t *signatures;
+	const IndexBandEntry *bands;
+	const char *strings;
+};
+
+#endif // SIMILARITY_H
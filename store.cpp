@@ -0,0 +1,325 @@
+/*	The columnar instruction store; see store.h. */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "store.h"
+
+namespace {
+
+/*
+	An operand's first byte is its mode in the low five bits and a three-bit
+	code above: the register for modes 0 to 6; for absolute modes, how many
+	bytes hold the address, sign extended; for PC-relative modes, the
+	offset of the extension word within the instruction, in words; and for
+	immediates and the rest, how many bytes hold the value, plus a flag for an
+	immediate that came from an effective address, which carries register 4.
+*/
+const unsigned int mode_bits = 5;
+const uint8_t mode_mask = 0x1f;
+const unsigned int value_bytes[4] = {0, 1, 2, 4};
+const uint8_t ea_immediate = 0x04;
+
+void put(std::vector<uint8_t> &out, uint32_t value, unsigned int bytes) {
+	for (unsigned int b = 0; b < bytes; ++b) out.push_back(uint8_t(value >> (8 * b)));
+}
+
+/* @returns @c bytes bytes from @c p, sign extended. */
+int32_t get(const uint8_t *&p, unsigned int bytes) {
+	uint32_t value = 0;
+	for (unsigned int b = 0; b < bytes; ++b) value |= uint32_t(*p++) << (8 * b);
+	if (bytes && bytes < 4 && (value >> (8 * bytes - 1)) & 1) value |= ~uint32_t(0) << (8 * bytes);
+	return int32_t(value);
+}
+
+/* @returns The fewest bytes that hold @c value when sign extended. */
+unsigned int value_length(int32_t value) {
+	if (!value) return 0;
+	if (value == int8_t(value)) return 1;
+	if (value == int16_t(value)) return 2;
+	if (value == (int32_t(uint32_t(value) << 8) >> 8)) return 3;
+	return 4;
+}
+
+/* @returns The smallest index into value_bytes holding @c value when sign extended. */
+unsigned int value_class(int32_t value) {
+	if (!value) return 0;
+	if (value == int8_t(value)) return 1;
+	if (value == int16_t(value)) return 2;
+	return 3;
+}
+
+void encode_operand(const Dis68kInstruction &inst, const Dis68kOperand &op, std::vector<uint8_t> &out) {
+	switch (op.mode) {
+		case ModeDataRegister: case ModeAddressRegister:
+		case ModeIndirect: case ModePostIncrement: case ModePreDecrement:
+			out.push_back(uint8_t(op.mode | op.reg << mode_bits));
+			break;
+
+		case ModeDisplacement:
+			out.push_back(uint8_t(op.mode | op.reg << mode_bits));
+			put(out, uint32_t(op.displacement), 2);
+			break;
+
+		case ModeIndexed:
+			out.push_back(uint8_t(op.mode | op.reg << mode_bits));
+			out.push_back(op.index);
+			out.push_back(uint8_t(op.displacement));
+			break;
+
+		case ModeAbsoluteShort:
+		case ModeAbsoluteLong: {
+			/* Addresses are usually 24-bit, or sign extended from 16. */
+			const unsigned int length = value_length(int32_t(op.value));
+			out.push_back(uint8_t(op.mode | length << mode_bits));
+			put(out, op.value, length);
+		} break;
+
+		case ModePCDisplacement:
+		case ModePCIndexed: {
+			/* The value is the extension word's address plus the displacement. */
+			const uint32_t extension = op.value - uint32_t(op.displacement) - inst.address;
+			out.push_back(uint8_t(op.mode | (extension >> 1) << mode_bits));
+			if (op.mode == ModePCDisplacement) {
+				put(out, uint32_t(op.displacement), 2);
+			} else {
+				out.push_back(op.index);
+				out.push_back(uint8_t(op.displacement));
+			}
+		} break;
+
+		default: {
+			/* Branch targets are kept relative to the instruction. */
+			const int32_t value = int32_t(op.mode == ModeBranchTarget ? op.value - inst.address : op.value);
+			const unsigned int size = value_class(value);
+			out.push_back(uint8_t(op.mode | (size | (op.reg ? ea_immediate : 0)) << mode_bits));
+			put(out, uint32_t(value), value_bytes[size]);
+		} break;
+	}
+}
+
+void decode_operand(const uint8_t *&p, uint32_t address, Dis68kOperand &op) {
+	const uint8_t mode = *p & mode_mask;
+	const uint8_t code = *p++ >> mode_bits;
+
+	op.mode = mode;
+	op.reg = 0;
+	op.index = 0;
+	op.displacement = 0;
+	op.value = 0;
+
+	switch (mode) {
+		case ModeDataRegister: case ModeAddressRegister:
+		case ModeIndirect: case ModePostIncrement: case ModePreDecrement:
+			op.reg = code;
+			break;
+
+		case ModeDisplacement:
+			op.reg = code;
+			op.displacement = get(p, 2);
+			break;
+
+		case ModeIndexed:
+			op.reg = code;
+			op.index = *p++;
+			op.displacement = get(p, 1);
+			break;
+
+		case ModeAbsoluteShort:
+		case ModeAbsoluteLong:
+			op.reg = mode - ModeAbsoluteShort;
+			op.value = uint32_t(get(p, code));
+			break;
+
+		case ModePCDisplacement:
+			op.reg = 2;
+			op.displacement = get(p, 2);
+			op.value = address + (uint32_t(code) << 1) + uint32_t(op.displacement);
+			break;
+
+		case ModePCIndexed:
+			op.reg = 3;
+			op.index = *p++;
+			op.displacement = get(p, 1);
+			op.value = address + (uint32_t(code) << 1) + uint32_t(op.displacement);
+			break;
+
+		default:
+			op.reg = (code & ea_immediate) ? 4 : 0;
+			op.value = uint32_t(get(p, value_bytes[code & 3]));
+			if (mode == ModeBranchTarget) op.value += address;
+			break;
+	}
+}
+
+/* The Flow that decode gives @c opnum; @c condition distinguishes BRA and BSR. */
+uint8_t flow_of(unsigned int opnum, unsigned int condition) {
+	switch (opnum) {
+		case OpBcc:		return condition == 0 ? FlowJump : (condition == 1 ? FlowCall : FlowBranch);
+		case OpDBcc:	return FlowBranch;
+		case OpJMP:		return FlowJump;
+		case OpJSR:		return FlowCall;
+		case OpRTE:
+		case OpRTR:
+		case OpRTS:		return FlowReturn;
+		case OpTRAP:
+		case OpTRAPV:	return FlowTrap;
+		default:		return FlowSequential;
+	}
+}
+
+}
+
+InstructionStore::InstructionStore() : next_address(0) {}
+
+void InstructionStore::append(const Dis68kInstruction &inst) {
+	const size_t index = size();
+	if (index % kStoreCheckpointInterval == 0) {
+		checkpoints.push_back(Checkpoint{inst.address, uint32_t(operands.size())});
+	} else if (inst.address != next_address) {
+		breaks.push_back(Break{uint32_t(index), inst.address});
+	}
+
+	opcodes.push_back(inst.opcode);
+	opnums.push_back(inst.opnum);
+	shapes.push_back(uint8_t((inst.length / 2 - 1) | inst.size << 3 | inst.operand_count << 5));
+	for (unsigned int k = 0; k < inst.operand_count; ++k) encode_operand(inst, inst.operands[k], operands);
+	next_address = inst.address + inst.length;
+}
+
+void InstructionStore::clear() {
+	opcodes.clear();
+	opnums.clear();
+	shapes.clear();
+	operands.clear();
+	checkpoints.clear();
+	breaks.clear();
+	next_address = 0;
+}
+
+void InstructionStore::shrink_to_fit() {
+	opcodes.shrink_to_fit();
+	opnums.shrink_to_fit();
+	shapes.shrink_to_fit();
+	operands.shrink_to_fit();
+	checkpoints.shrink_to_fit();
+	breaks.shrink_to_fit();
+}
+
+size_t InstructionStore::memory() const {
+	return opcodes.size() * sizeof(uint16_t) + opnums.size() + shapes.size() + operands.size() +
+		checkpoints.size() * sizeof(Checkpoint) + breaks.size() * sizeof(Break);
+}
+
+size_t InstructionStore::read(size_t index, uint32_t address, size_t offset, Dis68kInstruction &inst) const {
+	const uint8_t shape = shapes[index];
+	inst.address = address;
+	inst.opcode = opcodes[index];
+	inst.opnum = opnums[index];
+	inst.length = uint8_t(((shape & 7) + 1) * 2);
+	inst.size = (shape >> 3) & 3;
+	inst.operand_count = shape >> 5;
+
+	const uint8_t *p = operands.data() + offset;
+	for (unsigned int k = 0; k < inst.operand_count; ++k) decode_operand(p, address, inst.operands[k]);
+
+	/* Bcc, DBcc and Scc hold their condition in bits 8 to 11; the rest have none. */
+	const bool conditional = inst.opnum == OpBcc || inst.opnum == OpDBcc || inst.opnum == OpScc;
+	inst.condition = conditional ? (inst.opcode >> 8) & 15 : 0;
+	inst.flow = flow_of(inst.opnum, inst.condition);
+
+	/* Branches carry their target as an operand; JMP and JSR have one if it is a known address. */
+	inst.has_target = false;
+	inst.target = 0;
+	for (unsigned int k = 0; k < inst.operand_count; ++k) {
+		if (inst.operands[k].mode == ModeBranchTarget) {
+			inst.has_target = true;
+			inst.target = inst.operands[k].value;
+		}
+	}
+	if ((inst.opnum == OpJMP || inst.opnum == OpJSR) && inst.operand_count) {
+		const uint8_t mode = inst.operands[0].mode;
+		if (mode == ModeAbsoluteShort || mode == ModeAbsoluteLong || mode == ModePCDisplacement) {
+			inst.has_target = true;
+			inst.target = inst.operands[0].value;
+		}
+	}
+	return size_t(p - operands.data());
+}
+
+Dis68kInstruction InstructionStore::operator[](size_t index) const {
+	return *iterator_at(index);
+}
+
+size_t InstructionStore::lower_bound(uint32_t address) const {
+	/* The last checkpoint at or before the address, then a walk from it. */
+	const auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), address, [](uint32_t a, const Checkpoint &checkpoint) {
+		return a < checkpoint.address;
+	});
+	if (after == checkpoints.begin()) return 0;
+
+	for (const_iterator it = iterator_at(size_t(after - 1 - checkpoints.begin()) * kStoreCheckpointInterval); it != end(); ++it) {
+		if (it->address >= address) return it.position();
+	}
+	return size();
+}
+
+InstructionStore::const_iterator InstructionStore::begin() const {
+	return const_iterator(this, 0);
+}
+
+InstructionStore::const_iterator InstructionStore::end() const {
+	return const_iterator(this, size());
+}
+
+InstructionStore::const_iterator InstructionStore::iterator_at(size_t index) const {
+	if (index >= size()) return end();
+
+	/* Walk forward from the checkpoint, taking addresses from lengths and breaks. */
+	const size_t first = index - index % kStoreCheckpointInterval;
+	const_iterator it(this, first);
+	while (it.index < index) ++it;
+	return it;
+}
+
+InstructionStore::const_iterator::const_iterator(const InstructionStore *_store, size_t _index) :
+	store(_store), index(_index), next_offset(0), next_break(0) {
+	memset(&inst, 0, sizeof(inst));
+	if (index >= store->size()) return;
+
+	/* Only ever constructed at a checkpoint. */
+	const Checkpoint &checkpoint = store->checkpoints[index / kStoreCheckpointInterval];
+	next_break = size_t(std::upper_bound(store->breaks.begin(), store->breaks.end(), uint32_t(index), [](uint32_t i, const Break &b) {
+		return i < b.index;
+	}) - store->breaks.begin());
+	next_offset = store->read(index, checkpoint.address, checkpoint.operand_offset, inst);
+}
+
+void InstructionStore::const_iterator::load() {
+	if (index >= store->size()) return;
+
+	uint32_t address = inst.address + inst.length;
+	if (index % kStoreCheckpointInterval == 0) {
+		address = store->checkpoints[index / kStoreCheckpointInterval].address;
+	} else if (next_break < store->breaks.size() && store->breaks[next_break].index == index) {
+		address = store->breaks[next_break++].address;
+	}
+	next_offset = store->read(index, address, next_offset, inst);
+}
+
+void store_listing(const void *begin, const void *end, uint32_t address, InstructionStore &store) {
+	const uint32_t end_address = address + uint32_t((const uint8_t *)end - (const uint8_t *)begin);
+
+	Dis68k dis(begin, end, address);
+	Dis68kInstruction inst;
+	while (dis.tell() - address < end_address - address) {
+		const uint32_t at = dis.tell();
+		if (dis.decode(inst) && !dis.overflowed()) {
+			store.append(inst);
+			continue;
+		}
+		dis.seek(at + ((end_address - at >= 2) ? 2 : 1));
+	}
+	store.shrink_to_fit();
+}
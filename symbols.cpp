@@ -0,0 +1,161 @@
+/*	Symbol tables; see symbols.h. */
+
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+
+#include <string>
+
+#include "symbols.h"
+
+namespace {
+
+bool name_start(char c) {
+	return isalpha((unsigned char)c) || c == '_' || c == '.' || c == '@';
+}
+
+bool valid_name(const std::string &name) {
+	if (name.empty() || name.size() > kMaxSymbolName || !name_start(name[0])) return false;
+	for (char c : name) {
+		if (!isalnum((unsigned char)c) && c != '_' && c != '.' && c != '@') return false;
+	}
+	return true;
+}
+
+/* Reads all of @c token as a number: $hex or 0xhex, otherwise in @c base. */
+bool parse_number(const std::string &token, int base, uint32_t &value) {
+	const char *digits = token.c_str();
+	if (*digits == '$') {
+		++digits, base = 16;
+	} else if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+		digits += 2, base = 16;
+	}
+	if (!isxdigit((unsigned char)*digits)) return false;
+
+	char *end;
+	errno = 0;
+	const unsigned long long parsed = strtoull(digits, &end, base);
+	if (*end || errno || parsed > 0xffffffffull) return false;
+	value = uint32_t(parsed);
+	return true;
+}
+
+/* Splits @c line into words at white space and around '='. */
+std::vector<std::string> split(const char *line) {
+	std::vector<std::string> words;
+	std::string word;
+	for (const char *p = line;; ++p) {
+		if (*p && !isspace((unsigned char)*p) && *p != '=') {
+			word += *p;
+			continue;
+		}
+		if (!word.empty()) words.push_back(word);
+		word.clear();
+		if (*p == '=') words.push_back("=");
+		if (!*p) break;
+	}
+	return words;
+}
+
+}
+
+SymbolTable::SymbolTable(uint32_t _address_mask) : address_mask(_address_mask), shift(0) {
+	/* At most 2^16 buckets, whatever the mask. */
+	const unsigned int bits = address_mask ? 32 - unsigned(__builtin_clz(address_mask)) : 0;
+	shift = bits > 16 ? bits - 16 : 0;
+}
+
+bool SymbolTable::add(uint32_t address, const char *name) {
+	const size_t length = strlen(name);
+	if (length > kMaxSymbolName) return false;
+	entries.push_back(Entry{address & address_mask, uint32_t(names.size())});
+	names.insert(names.end(), name, name + length + 1);
+	return true;
+}
+
+bool SymbolTable::load(const char *path) {
+	FILE *const in = fopen(path, "r");
+	if (!in) {
+		fprintf(stderr, "Couldn't open symbols %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	char *line = nullptr;
+	size_t capacity = 0;
+	size_t skipped = 0, first_skipped = 0, number = 0;
+	while (getline(&line, &capacity, in) >= 0) {
+		++number;
+
+		const char *start = line;
+		while (isspace((unsigned char)*start)) ++start;
+		if (*start == '*' || *start == '#') continue;
+		line[strcspn(line, ";\r\n")] = 0;
+
+		std::vector<std::string> words = split(line);
+		if (words.empty()) continue;
+
+		uint32_t value;
+		if (words.size() == 3 && (words[1] == "=" || !strcasecmp(words[1].c_str(), "equ"))) {
+			/* NAME EQU value, or NAME = value. */
+			std::string &name = words[0];
+			if (name.back() == ':') name.pop_back();
+			if (valid_name(name) && parse_number(words[2], 10, value)) {
+				add(value, name.c_str());
+				continue;
+			}
+		} else if ((words.size() == 2 || (words.size() == 3 && words[1].size() == 1)) && parse_number(words[0], 16, value)) {
+			/* address name, or address type name. */
+			const std::string &name = words.back();
+			if (valid_name(name)) {
+				add(value, name.c_str());
+				continue;
+			}
+		}
+
+		if (!skipped++) first_skipped = number;
+	}
+	free(line);
+
+	const bool read = !ferror(in);
+	fclose(in);
+	if (!read) {
+		fprintf(stderr, "Couldn't read symbols %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	if (skipped) fprintf(stderr, "%s: %zu lines not understood, the first at line %zu\n", path, skipped, first_skipped);
+	return true;
+}
+
+void SymbolTable::build() {
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return a.address < b.address;
+	});
+	entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return a.address == b.address;
+	}), entries.end());
+
+	/* Count the entries of each bucket, then sum into the offset of each. */
+	directory.assign(size_t(address_mask >> shift) + 2, 0);
+	for (const Entry &entry : entries) ++directory[(entry.address >> shift) + 1];
+	for (size_t b = 1; b < directory.size(); ++b) directory[b] += directory[b - 1];
+}
+
+bool write_symbolic_listing(const void *begin, const void *end, uint32_t address, const SymbolTable &symbols, FILE *out, OutputSyntax syntax) {
+	const uint32_t end_address = address + uint32_t((const uint8_t *)end - (const uint8_t *)begin);
+
+	return with_syntax(syntax, [&](auto policy) {
+		typedef decltype(policy) Syntax;
+
+		Dis68k dis(begin, end, address);
+		char line[kMaxListingLine];
+		while (dis.tell() - address < end_address - address) {
+			const char *const label = symbols.find(dis.tell());
+			if (label && fprintf(out, "%s:\n", label) < 0) return false;
+
+			const size_t length = symbolic_listing_line<Syntax>(dis, symbols, line, sizeof(line));
+			if (fwrite(line, 1, length, out) != length) return false;
+		}
+		return true;
+	});
+}
@@ -0,0 +1,133 @@
+#if !defined( SYMBOLS_H )
+#define SYMBOLS_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "dis68k.h"
+#include "listing.h"
+
+/*!
+	Names for addresses: labels from symbol files, and hardware registers from
+	definition files, looked up while formatting.
+
+	Entries live in one flat array sorted by address, eight bytes each, with
+	the names packed into a single string table. A directory indexed by the top
+	16 bits of the masked address gives the run of entries sharing those bits,
+	so a lookup is two loads and a binary search over a few entries, however
+	large the table. Addresses that no symbol shares the top bits of cost no
+	search at all.
+*/
+class SymbolTable
+{
+public:
+	/*!
+		@param _address_mask Applied to every address added and looked up; the 68000 ignores the top byte.
+	*/
+	explicit SymbolTable(uint32_t _address_mask = 0x00ffffff);
+
+	/*!
+		Adds @c name for @c address. Where an address is given several names, the first added is kept.
+
+		@returns @c false, adding nothing, if @c name is longer than kMaxSymbolName characters.
+	*/
+	bool add(uint32_t address, const char *name);
+
+	/*!
+		Adds every symbol in the text file at @c path. Each line may be either
+		an assembler equate, @c "NAME EQU $DFF180" or @c "NAME = $DFF180", with
+		a decimal value unless marked @c $ or @c 0x; or an address then a name,
+		as in a linker map or the output of nm, @c "00FC0000 T _start", with a
+		hex address. Comments start with @c ; anywhere or @c * or @c # at the
+		start of a line. Lines that are neither, or whose name is longer than
+		kMaxSymbolName characters, are counted and reported.
+
+		@returns @c false, having printed a diagnostic, if the file can't be read.
+	*/
+	bool load(const char *path);
+
+	/// Sorts what has been added and builds the directory. Call once all symbols are in, before find.
+	void build();
+
+	/// @returns The name for @c address, or null.
+	const char *find(uint32_t address) const
+	{
+		address &= address_mask;
+		const uint32_t bucket = address >> shift;
+		if( bucket + 1 >= directory.size() ) return nullptr;
+
+		const Entry *const first = entries.data() + directory[bucket];
+		const Entry *const last = entries.data() + directory[bucket + 1];
+		const Entry *const found = std::lower_bound(first, last, address, [](const Entry &entry, uint32_t a) {
+			return entry.address < a;
+		});
+		return ( found != last && found->address == address ) ? names.data() + found->name : nullptr;
+	}
+
+	/// @returns The number of distinct addresses named, once built.
+	size_t size() const
+	{
+		return entries.size();
+	}
+
+private:
+	struct Entry {
+		uint32_t address;
+		uint32_t name;		// offset into names
+	};
+
+	uint32_t address_mask;
+	unsigned int shift;					// from a masked address to its directory bucket
+	std::vector<Entry> entries;
+	std::vector<char> names;
+	std::vector<uint32_t> directory;	// bucket count + 1 offsets into entries
+};
+
+/// A TextVisitor that prints absolute addresses and branch targets by name where @c symbols has one.
+template<typename Syntax>
+struct SymbolTextVisitor: public TextVisitor<Syntax> {
+	SymbolTextVisitor(char *_out_s, size_t _out_sz, const SymbolTable &_symbols) : TextVisitor<Syntax>(_out_s, _out_sz), symbols(_symbols) {}
+
+	const char *symbol(uint32_t address)
+	{
+		return symbols.find(address);
+	}
+
+	const SymbolTable &symbols;
+};
+
+/*!
+	Prints one listing line, as listing_line does, with names from @c symbols
+	in place of absolute addresses and branch targets.
+
+	@returns The length of the line, as snprintf would.
+*/
+template<typename Syntax, typename View>
+size_t symbolic_listing_line(BasicDis68k<View> &dis, const SymbolTable &symbols, char *out_s, size_t out_sz)
+{
+	char text[kMaxListingLine - 10];
+	const uint32_t address = dis.tell();
+	SymbolTextVisitor<Syntax> visitor(text, sizeof(text), symbols);
+
+	if( dis.decode(visitor) && !dis.overflowed() )
+	{
+		return snprintf(out_s, out_sz, "%08x\t%s", address, text);
+	}
+	dis.seek(address);
+	return listing_line<Syntax>(dis, out_s, out_sz);
+}
+
+/*!
+	Writes the listing of write_listing with names from @c symbols in place of
+	absolute addresses and branch targets, and a label line before each
+	instruction at a named address.
+
+	@returns @c false on a write error.
+*/
+bool write_symbolic_listing(const void *begin, const void *end, uint32_t address, const SymbolTable &symbols, FILE *out, OutputSyntax syntax = OutputSyntax::Motorola);
+
+#endif // SYMBOLS_H
@@ -0,0 +1,63 @@
+/*	Functions found from entry points, calls and LINK prologues. */
+
+#include <vector>
+
+#include "analysis.h"
+#include "check.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x61, 0x00, 0x00, 0x06,					// 1000 BSR $1008
+	0x4e, 0x75,								// 1004 RTS
+	0x4e, 0x71,								// 1006 NOP, never reached
+	0x4e, 0x75,								// 1008 RTS
+	0x4e, 0x56, 0xff, 0xfc,					// 100a LINK A6,#-4
+	0x4e, 0x5e,								// 100e UNLK A6
+	0x4e, 0x75,								// 1010 RTS
+	0x4e, 0x56, 0x00, 0x00,					// 1012 LINK A6,#0
+	0x60, 0xfe,								// 1016 BRA $1016, never returning
+	0x4e, 0x56, 0x00, 0x00,					// 1018 LINK A6,#0
+	0xff, 0xff,								// 101c not an instruction
+	0x4e, 0x75								// 101e RTS
+};
+
+}
+
+int main()
+{
+	Program program;
+	CHECK(analyse_program(code, code + sizeof(code), 0x1000, std::vector<uint32_t>(1, 0x1000), program, 2));
+
+	CHECK(program.functions.size() == 3);
+	const long entry = program.find_function(0x1000), callee = program.find_function(0x1008);
+	const long prologue = program.find_function(0x100a);
+	CHECK(entry == 0 && callee == 1 && prologue == 2);
+	if( program.functions.size() == 3 )
+	{
+		CHECK(program.functions[0].origin == OriginEntryPoint && program.functions[0].returns);
+		CHECK(program.functions[1].origin == OriginCall && program.functions[1].returns);
+		CHECK(program.functions[2].origin == OriginPrologue && program.functions[2].returns);
+	}
+
+	/* Prologues that loop forever or run into data aren't functions. */
+	CHECK(program.find_function(0x1012) == -1);
+	CHECK(program.find_function(0x1018) == -1);
+
+	CHECK(program.calls.node_count() == 3);
+	if( program.calls.node_count() == 3 )
+	{
+		CHECK(program.calls.degree(0) == 1 && *program.calls.begin(0) == 1);
+		CHECK(program.calls.degree(1) == 0 && program.calls.degree(2) == 0);
+	}
+
+	/* Every block lies within the image and holds its last instruction. */
+	for( const BasicBlock &block : program.blocks )
+	{
+		CHECK(block.start >= 0x1000 && block.end <= 0x1000 + sizeof(code));
+		CHECK(block.last >= block.start && block.last < block.end);
+	}
+	CHECK(program.cfg.node_count() == program.blocks.size());
+
+	return check_result("analysis");
+}
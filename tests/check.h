@@ -0,0 +1,46 @@
+#if !defined( CHECK_H )
+#define CHECK_H 1
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+	The checks behind make test. Each test is a program that runs its checks
+	and returns check_result(); a failed check prints where it failed and the
+	run carries on, so that one program reports every failure at once.
+*/
+
+static int check_failures = 0;
+
+#define CHECK(condition)															\
+	do {																			\
+		if( !(condition) )															\
+		{																			\
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);	\
+			++check_failures;														\
+		}																			\
+	} while( false )
+
+#define CHECK_STRING(actual, expected)												\
+	do {																			\
+		const char *const check_actual = (actual), *const check_expected = (expected);	\
+		if( strcmp(check_actual, check_expected) )									\
+		{																			\
+			fprintf(stderr, "%s:%d: expected \"%s\", got \"%s\"\n", __FILE__, __LINE__, check_expected, check_actual);	\
+			++check_failures;														\
+		}																			\
+	} while( false )
+
+/// @returns The exit status for the test @c name, having reported its result.
+inline int check_result(const char *name)
+{
+	if( check_failures )
+	{
+		fprintf(stderr, "%s: %d checks failed\n", name, check_failures);
+		return 1;
+	}
+	printf("%s: ok\n", name);
+	return 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,115 @@
+/*	Known-answer timings from the M68000 Programmer's Reference Manual. */
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "cycles.h"
+
+namespace {
+
+struct Timing {
+	uint8_t code[6];
+	uint8_t length;
+	uint16_t cycles, taken;
+	bool variable;
+	const char *name;
+};
+
+const Timing timings[] = {
+	{{0x32, 0x00}, 2, 4, 4, false, "MOVE.W D0,D1"},
+	{{0x22, 0x10}, 2, 12, 12, false, "MOVE.L (A0),D1"},
+	{{0x33, 0x28, 0x00, 0x10}, 4, 16, 16, false, "MOVE.W 16(A0),-(A1)"},
+	{{0xd2, 0x80}, 2, 8, 8, false, "ADD.L D0,D1"},
+	{{0xd2, 0x50}, 2, 8, 8, false, "ADD.W (A0),D1"},
+	{{0xd3, 0x50}, 2, 12, 12, false, "ADD.W D1,(A0)"},
+	{{0x02, 0x40, 0x00, 0x01}, 4, 8, 8, false, "ANDI.W #1,D0"},
+	{{0x02, 0x80, 0x00, 0x00, 0x00, 0x01}, 6, 14, 14, false, "ANDI.L #1,D0"},
+	{{0x00, 0x80, 0x00, 0x00, 0x00, 0x01}, 6, 16, 16, false, "ORI.L #1,D0"},
+	{{0x0a, 0x80, 0x00, 0x00, 0x00, 0x01}, 6, 16, 16, false, "EORI.L #1,D0"},
+	{{0x02, 0x10, 0x00, 0x01}, 4, 16, 16, false, "ANDI.B #1,(A0)"},
+	{{0x02, 0x90, 0x00, 0x00, 0x00, 0x01}, 6, 28, 28, false, "ANDI.L #1,(A0)"},
+	{{0x0c, 0x80, 0x00, 0x00, 0x00, 0x01}, 6, 14, 14, false, "CMPI.L #1,D0"},
+	{{0x42, 0x80}, 2, 6, 6, false, "CLR.L D0"},
+	{{0x66, 0x02}, 2, 8, 10, false, "BNE.S"},
+	{{0x66, 0x00, 0x00, 0x02}, 4, 12, 10, false, "BNE.W"},
+	{{0x60, 0x02}, 2, 10, 10, false, "BRA.S"},
+	{{0x61, 0x02}, 2, 18, 18, false, "BSR.S"},
+	{{0x51, 0xc8, 0xff, 0xfe}, 4, 14, 10, false, "DBF D0"},
+	{{0x4e, 0x90}, 2, 16, 16, false, "JSR (A0)"},
+	{{0x4e, 0xb9, 0x00, 0x00, 0x10, 0x00}, 6, 20, 20, false, "JSR $1000.L"},
+	{{0x41, 0xf9, 0x00, 0x00, 0x10, 0x00}, 6, 12, 12, false, "LEA $1000.L,A0"},
+	{{0x48, 0xe7, 0xc0, 0xc0}, 4, 40, 40, false, "MOVEM.L D0-D1/A0-A1,-(A7)"},
+	{{0xe5, 0x48}, 2, 10, 10, false, "LSL.W #2,D0"},
+	{{0xc2, 0xc0}, 2, 70, 70, true, "MULU D0,D1"},
+	{{0x4e, 0x76}, 2, 4, 34, false, "TRAPV"},
+	{{0x4e, 0x75}, 2, 16, 16, false, "RTS"}
+};
+
+/* A loop: the DBF's block costs 18 when it expires and 14 when it loops. */
+const uint8_t loop[] = {
+	0x70, 0x00,								// 1000 MOVEQ #0,D0
+	0x52, 0x40,								// 1002 ADDQ.W #1,D0
+	0x51, 0xc9, 0xff, 0xfc,					// 1004 DBF D1,$1002
+	0x4e, 0x75								// 1008 RTS
+};
+
+}
+
+int main()
+{
+	for( const Timing &expected : timings )
+	{
+		Dis68k dis(expected.code, expected.code + expected.length, 0x1000);
+		Dis68kInstruction inst;
+		InstructionCycles timing;
+		const bool decoded = dis.decode(inst) && inst.length == expected.length;
+		if( !decoded || !instruction_cycles(inst, timing) )
+		{
+			fprintf(stderr, "%s: not timed\n", expected.name);
+			CHECK(false);
+			continue;
+		}
+		if( timing.cycles != expected.cycles || timing.taken != expected.taken || timing.variable != expected.variable )
+		{
+			fprintf(stderr, "%s: %u/%u%s, expected %u/%u%s\n", expected.name, timing.cycles, timing.taken, timing.variable ? "*" : "",
+				expected.cycles, expected.taken, expected.variable ? "*" : "");
+			CHECK(false);
+		}
+	}
+
+	Program program;
+	CHECK(analyse_program(loop, loop + sizeof(loop), 0x1000, std::vector<uint32_t>(1, 0x1000), program, 1));
+	std::vector<BlockCycles> totals;
+	block_cycles(loop, loop + sizeof(loop), 0x1000, program, totals, 1);
+	CHECK(totals.size() == program.blocks.size() && totals.size() == 3);
+	for( size_t b = 0; b < totals.size(); ++b )
+	{
+		switch( program.blocks[b].start )
+		{
+			case 0x1000: CHECK(totals[b].cycles == 4 && totals[b].taken == 4); break;
+			case 0x1002: CHECK(totals[b].cycles == 18 && totals[b].taken == 14); break;
+			case 0x1008: CHECK(totals[b].cycles == 16 && totals[b].taken == 16); break;
+			default: CHECK(false);
+		}
+	}
+
+	/* Instruction and block comments both follow the output syntax. */
+	FILE *out = tmpfile();
+	CHECK(write_timed_listing(loop, loop + sizeof(loop), 0x1000, &program, out, OutputSyntax::Gnu));
+	rewind(out);
+	std::string text;
+	char line[256];
+	while( fgets(line, sizeof(line), out) ) text += line;
+	fclose(out);
+	CHECK_STRING(text.c_str(),
+		"00001000\t\tmoveq\t#0x00,%d0\t| 4\n"
+		"\t\t| block 0x00001000: 4\n"
+		"00001002\t\taddq.w\t#1,%d0\t| 4\n"
+		"00001004\t\tdbf\t%d1,0x00001002\t| 10/14\n"
+		"\t\t| block 0x00001002: 14/18\n"
+		"00001008\t\trts\t| 16\n"
+		"\t\t| block 0x00001008: 16\n");
+
+	return check_result("cycles");
+}
@@ -0,0 +1,97 @@
+/*	Diffs of two revisions: moved, changed, added and removed functions. */
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "diff.h"
+
+namespace {
+
+#define BSR(from, to)	0x61, 0x00, uint8_t(( (to) - (from) - 2 ) >> 8), uint8_t((to) - (from) - 2)
+
+const uint8_t old_code[] = {
+	BSR(0x1000, 0x100e),					// 1000
+	BSR(0x1004, 0x1012),					// 1004
+	BSR(0x1008, 0x101a),					// 1008
+	0x4e, 0x75,								// 100c RTS
+	0x70, 0x01, 0x4e, 0x75,					// 100e MOVEQ #1,D0; RTS
+	0x70, 0x02,								// 1012 MOVEQ #2,D0
+	0x67, 0x02,								// 1014 BEQ $1018
+	0x52, 0x80,								// 1016 ADDQ.L #1,D0
+	0x4e, 0x75,								// 1018 RTS
+	0x70, 0x03, 0x4e, 0x75					// 101a MOVEQ #3,D0; RTS
+};
+
+const uint8_t new_code[] = {
+	BSR(0x1000, 0x1014),					// 1000
+	BSR(0x1004, 0x1018),					// 1004
+	BSR(0x1008, 0x1020),					// 1008
+	BSR(0x100c, 0x1024),					// 100c
+	0x4e, 0x75,								// 1010 RTS
+	0x4e, 0x71,								// 1012 NOP, never reached
+	0x70, 0x01, 0x4e, 0x75,					// 1014 MOVEQ #1,D0; RTS, moved
+	0x70, 0x02,								// 1018 MOVEQ #2,D0
+	0x67, 0x02,								// 101a BEQ $101e
+	0x54, 0x80,								// 101c ADDQ.L #2,D0, changed
+	0x4e, 0x75,								// 101e RTS
+	0x70, 0x04, 0x4e, 0x75,					// 1020 MOVEQ #4,D0; RTS
+	0x70, 0x05, 0x4e, 0x71, 0x4e, 0x75		// 1024 MOVEQ #5,D0; NOP; RTS
+};
+
+#undef BSR
+
+const FunctionChange *find_change(const RomDiff &diff, uint32_t old_entry, uint32_t new_entry)
+{
+	for( const FunctionChange &change : diff.changes )
+	{
+		if( change.old_entry == old_entry && change.new_entry == new_entry ) return &change;
+	}
+	return nullptr;
+}
+
+}
+
+int main()
+{
+	DiffImage old_image = { old_code, old_code + sizeof(old_code), 0x1000, std::vector<uint32_t>(1, 0x1000) };
+	DiffImage new_image = { new_code, new_code + sizeof(new_code), 0x1000, std::vector<uint32_t>(1, 0x1000) };
+
+	RomDiff diff;
+	CHECK(diff_images(old_image, new_image, diff, 2));
+	CHECK(diff.unchanged == 1 && diff.changed == 2 && diff.added == 2 && diff.removed == 1);
+	CHECK(diff.changes.size() == 6);
+
+	/* Code that has only moved hashes the same. */
+	const FunctionChange *moved = find_change(diff, 0x100e, 0x1014);
+	CHECK(moved && moved->kind == FunctionUnchanged && moved->shared_blocks == 1);
+
+	const FunctionChange *changed = find_change(diff, 0x1012, 0x1018);
+	CHECK(changed && changed->kind == FunctionChanged);
+	CHECK(changed && changed->old_blocks == 3 && changed->new_blocks == 3 && changed->shared_blocks == 2);
+
+	const FunctionChange *entry = find_change(diff, 0x1000, 0x1000);
+	CHECK(entry && entry->kind == FunctionChanged);
+
+	/* Two new functions where one went: neither pairs with it by position. */
+	const FunctionChange *added = find_change(diff, 0, 0x1020), *also_added = find_change(diff, 0, 0x1024);
+	CHECK(added && added->kind == FunctionAdded && also_added && also_added->kind == FunctionAdded);
+	const FunctionChange *removed = find_change(diff, 0x101a, 0);
+	CHECK(removed && removed->kind == FunctionRemoved);
+	CHECK(diff.changes.back().kind == FunctionRemoved);
+
+	FILE *out = tmpfile();
+	CHECK(write_diff(diff, out));
+	rewind(out);
+	std::string text;
+	char line[256];
+	while( fgets(line, sizeof(line), out) ) text += line;
+	fclose(out);
+	CHECK(text.find("unchanged\n") == std::string::npos);
+	CHECK(text.find("~ $00001012 -> $00001018\t2 of 3 blocks shared") != std::string::npos);
+	CHECK(text.find("+ $00001020\t\t1 blocks\n") != std::string::npos);
+	CHECK(text.find("- $0000101a\t\t1 blocks\n") != std::string::npos);
+	CHECK(text.find("1 unchanged, 2 changed, 2 added, 1 removed\n") != std::string::npos);
+
+	return check_result("diff");
+}
@@ -0,0 +1,69 @@
+/*	Decoder counters, from this thread and from one that has exited. */
+
+#define DIS68K_INSTRUMENT 1
+
+#include <stdlib.h>
+
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "dis68k.h"
+
+namespace {
+
+/* Decodes are instantiated here, with the hooks, for this visitor alone. */
+struct CountingVisitor: public Dis68kVisitor {};
+
+const uint8_t code[] = {
+	0x4e, 0x71,		// NOP
+	0x22, 0x00,		// MOVE.L D0,D1
+	0xff, 0xff,		// not an instruction
+	0x4e, 0x75		// RTS
+};
+
+void decode_all()
+{
+	Dis68k dis(code, code + sizeof(code), 0);
+	CountingVisitor visitor;
+	while( dis.tell() < sizeof(code) )
+	{
+		const uint32_t at = dis.tell();
+		if( !dis.decode(visitor) ) dis.seek(at + 2);
+	}
+}
+
+}
+
+int main()
+{
+	decode_all();
+	std::thread worker(decode_all);
+	worker.join();
+
+	Dis68kCounters *const totals = new Dis68kCounters();
+	instrument_snapshot(totals);
+	CHECK(totals->instructions == 6);
+	CHECK(totals->undecoded == 2);
+	CHECK(totals->bytes == 16);
+	CHECK(totals->hits[OpNOP] == 2);
+	CHECK(totals->hits[OpMOVE] == 2);
+	CHECK(totals->hits[OpRTS] == 2);
+	CHECK(totals->hits[OpABCD] == 0);
+	delete totals;
+
+	CHECK(instruction_class(OpBcc) == ClassBranch);
+	CHECK(instruction_class(OpMOVEQ) == ClassMove);
+	CHECK(instruction_class(0) == ClassUndecoded);
+
+	FILE *const json = tmpfile();
+	instrument_write_json(json);
+	rewind(json);
+	std::string text;
+	for( int c; ( c = fgetc(json) ) != EOF; ) text += char(c);
+	fclose(json);
+	CHECK(text.find("\"instructions\": 6,") != std::string::npos);
+	CHECK(text.find("\"name\": \"NOP\", \"hits\": 2") != std::string::npos);
+
+	return check_result("instrument");
+}
@@ -0,0 +1,80 @@
+/*	Jump tables recovered behind JMP d(PC,Xn): word offsets and branch runs. */
+
+#include <vector>
+
+#include "analysis.h"
+#include "check.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x0c, 0x40, 0x00, 0x02,					// 1000 CMPI.W #2,D0
+	0x62, 0x16,								// 1004 BHI $101c
+	0xd0, 0x40,								// 1006 ADD.W D0,D0
+	0x30, 0x3b, 0x00, 0x06,					// 1008 MOVE.W 6(PC,D0.W),D0
+	0x4e, 0xfb, 0x00, 0x02,					// 100c JMP 2(PC,D0.W)
+	0x00, 0x06, 0x00, 0x08, 0x00, 0x0a,		// 1010 offsets from $1010
+	0x4e, 0x75,								// 1016 RTS
+	0x4e, 0x75,								// 1018 RTS
+	0x4e, 0x75,								// 101a RTS
+	0x4e, 0x75,								// 101c RTS
+	0x4e, 0x71,								// 101e NOP
+
+	0xe5, 0x48,								// 1020 LSL.W #2,D0
+	0x4e, 0xfb, 0x00, 0x02,					// 1022 JMP 2(PC,D0.W)
+	0x60, 0x00, 0x00, 0x0a,					// 1026 BRA $1032
+	0x60, 0x00, 0x00, 0x08,					// 102a BRA $1034
+	0x60, 0x00, 0x00, 0x06,					// 102e BRA $1036
+	0x4e, 0x75,								// 1032 RTS
+	0x4e, 0x75,								// 1034 RTS
+	0x4e, 0x75								// 1036 RTS
+};
+
+/* @returns The starts of the successors of the block ending at @c last, in order. */
+std::vector<uint32_t> successors(const Program &program, uint32_t last)
+{
+	std::vector<uint32_t> starts;
+	for( uint32_t b = 0; b < program.blocks.size(); ++b )
+	{
+		if( program.blocks[b].last != last ) continue;
+		for( const uint32_t *s = program.cfg.begin(b); s != program.cfg.end(b); ++s ) starts.push_back(program.blocks[*s].start);
+	}
+	return starts;
+}
+
+}
+
+int main()
+{
+	std::vector<uint32_t> entries;
+	entries.push_back(0x1000);
+	entries.push_back(0x1020);
+
+	Program program;
+	CHECK(analyse_program(code, code + sizeof(code), 0x1000, entries, program, 1));
+	CHECK(program.jump_tables.size() == 2);
+	if( program.jump_tables.size() != 2 ) return check_result("jumptables");
+
+	/* Bounded by the CMPI and BHI in front of it. */
+	const JumpTable &offsets = program.jump_tables[0];
+	CHECK(offsets.dispatch == 0x100c && offsets.table == 0x1010 && offsets.base == 0x1010);
+	CHECK(offsets.kind == JumpTableOffsets && offsets.entry_size == 2);
+	CHECK(offsets.count == 3 && offsets.bounded);
+	CHECK(offsets.function == unsigned(program.find_function(0x1000)));
+
+	const uint32_t offset_cases[] = { 0x1016, 0x1018, 0x101a };
+	CHECK(successors(program, 0x100c) == std::vector<uint32_t>(offset_cases, offset_cases + 3));
+
+	/* Unbounded, so it ends where the first case begins. */
+	const JumpTable &branches = program.jump_tables[1];
+	CHECK(branches.dispatch == 0x1022 && branches.table == 0x1026 && branches.base == 0x1026);
+	CHECK(branches.kind == JumpTableBranches && branches.entry_size == 4);
+	CHECK(branches.count == 3 && !branches.bounded);
+	CHECK(branches.function == unsigned(program.find_function(0x1020)));
+
+	const uint32_t branch_cases[] = { 0x1026, 0x102a, 0x102e };
+	CHECK(successors(program, 0x1022) == std::vector<uint32_t>(branch_cases, branch_cases + 3));
+	CHECK(successors(program, 0x102a) == std::vector<uint32_t>(1, 0x1034));
+
+	return check_result("jumptables");
+}
@@ -0,0 +1,105 @@
+/*	Parallel listings match write_listing, and invalid modes list as data. */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "listing.h"
+
+namespace {
+
+std::string read_all(FILE *file)
+{
+	std::string text;
+	char buffer[65536];
+	rewind(file);
+	size_t got;
+	while( ( got = fread(buffer, 1, sizeof(buffer), file) ) > 0 ) text.append(buffer, got);
+	return text;
+}
+
+std::string reference_listing(const std::vector<uint8_t> &image, uint32_t address)
+{
+	FILE *out = tmpfile();
+	CHECK(write_listing(image.data(), image.data() + image.size(), address, out));
+	const std::string text = read_all(out);
+	fclose(out);
+	return text;
+}
+
+std::string parallel_listing(const std::vector<uint8_t> &image, uint32_t address, unsigned int threads)
+{
+	FILE *out = tmpfile();
+	CHECK(write_listing_parallel(image.data(), image.data() + image.size(), address, fileno(out), OutputSyntax::Motorola, threads));
+	const std::string text = read_all(out);
+	fclose(out);
+	return text;
+}
+
+/* The same, written to a pipe, which takes the buffered path. */
+std::string parallel_pipe_listing(const std::vector<uint8_t> &image, uint32_t address, unsigned int threads)
+{
+	int fds[2];
+	CHECK(pipe(fds) == 0);
+	std::string text;
+	std::thread drain([&text, fds] {
+		char buffer[65536];
+		ssize_t got;
+		while( ( got = read(fds[0], buffer, sizeof(buffer)) ) > 0 ) text.append(buffer, size_t(got));
+	});
+	CHECK(write_listing_parallel(image.data(), image.data() + image.size(), address, fds[1], OutputSyntax::Motorola, threads));
+	close(fds[1]);
+	drain.join();
+	close(fds[0]);
+	return text;
+}
+
+/* Each uses the effective address mode 7, register 5, which doesn't exist. */
+const uint16_t invalid_modes[] = {
+	0xd07d,		// ADD.W <ea>,D0
+	0xd17d,		// ADD.W D0,<ea>
+	0xd0fd,		// ADDA.W <ea>,A0
+	0xb0fd,		// CMPA.W <ea>,A0
+	0x307d		// MOVEA.W <ea>,A0
+};
+
+}
+
+int main()
+{
+	/* Arbitrary words, so that chunks start mid-instruction, ending on an odd byte. */
+	std::vector<uint8_t> image(1024 * 1024 + 1);
+	srand(68000);
+	for( uint8_t &byte : image ) byte = uint8_t(rand() >> 4);
+
+	const uint32_t address = 0x20000;
+	const std::string expected = reference_listing(image, address);
+	for( unsigned int threads = 1; threads <= 4; threads += 3 )
+	{
+		CHECK(parallel_listing(image, address, threads) == expected);
+		CHECK(parallel_pipe_listing(image, address, threads) == expected);
+	}
+
+	/* Invalid modes are data, however the words after them are set. */
+	for( uint16_t opcode : invalid_modes )
+	{
+		for( uint16_t filler : { 0x0000, 0xffff } )
+		{
+			const uint8_t code[] = {
+				uint8_t(opcode >> 8), uint8_t(opcode),
+				uint8_t(filler >> 8), uint8_t(filler), uint8_t(filler >> 8), uint8_t(filler)
+			};
+			Dis68k dis(code, code + sizeof(code), 0x1000);
+			char line[kMaxListingLine], expected_line[kMaxListingLine];
+			listing_line<MotorolaSyntax>(dis, line, sizeof(line));
+			snprintf(expected_line, sizeof(expected_line), "00001000\tDC.W     $%04X\n", opcode);
+			CHECK_STRING(line, expected_line);
+		}
+	}
+
+	return check_result("parallel");
+}
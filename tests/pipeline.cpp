@@ -0,0 +1,110 @@
+/*	The threaded pipeline lists as write_listing does, from a file or a pipe. */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "listing.h"
+#include "pipeline.h"
+#include "ring.h"
+
+namespace {
+
+std::string read_all(FILE *file)
+{
+	std::string text;
+	char buffer[65536];
+	rewind(file);
+	size_t got;
+	while( ( got = fread(buffer, 1, sizeof(buffer), file) ) > 0 ) text.append(buffer, got);
+	return text;
+}
+
+/* Lists @c image through run_pipeline, read from a temporary file or a pipe. */
+std::string pipeline_listing(const std::vector<uint8_t> &image, uint32_t address, bool from_pipe)
+{
+	FILE *out = tmpfile();
+	int in_fd;
+	std::thread feeder;
+	FILE *in = nullptr;
+	if( from_pipe )
+	{
+		int fds[2];
+		CHECK(pipe(fds) == 0);
+		in_fd = fds[0];
+		feeder = std::thread([&image, fds] {
+			for( size_t done = 0; done < image.size(); )
+			{
+				const ssize_t put = write(fds[1], image.data() + done, image.size() - done);
+				if( put <= 0 ) break;
+				done += size_t(put);
+			}
+			close(fds[1]);
+		});
+	}
+	else
+	{
+		in = tmpfile();
+		fwrite(image.data(), 1, image.size(), in);
+		fflush(in);
+		in_fd = fileno(in);
+		lseek(in_fd, 0, SEEK_SET);
+	}
+
+	CHECK(run_pipeline(in_fd, fileno(out), address));
+
+	if( from_pipe )
+	{
+		feeder.join();
+		close(in_fd);
+	}
+	else fclose(in);
+
+	const std::string text = read_all(out);
+	fclose(out);
+	return text;
+}
+
+}
+
+int main()
+{
+	/* Several input chunks of arbitrary words, ending on an odd byte. */
+	std::vector<uint8_t> image(3 * 1024 * 1024 + 1);
+	srand(68000);
+	for( uint8_t &byte : image ) byte = uint8_t(rand() >> 4);
+
+	const uint32_t address = 0x10000;
+	FILE *reference = tmpfile();
+	CHECK(write_listing(image.data(), image.data() + image.size(), address, reference));
+	const std::string expected = read_all(reference);
+	fclose(reference);
+	CHECK(expected.size() > image.size());
+
+	CHECK(pipeline_listing(image, address, false) == expected);
+	CHECK(pipeline_listing(image, address, true) == expected);
+
+	/* A consumer slower than its producer makes push sleep, and pop wakes it. */
+	SpscRing<unsigned int, 4> ring;
+	std::thread producer([&ring] {
+		for( unsigned int k = 0; k < 1000; ++k ) ring.push(k);
+	});
+	bool in_order = true;
+	for( unsigned int k = 0; k < 1000; ++k )
+	{
+		if( k % 100 == 0 ) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		in_order &= ring.pop() == k;
+	}
+	producer.join();
+	CHECK(in_order);
+
+	unsigned int value;
+	CHECK(!ring.try_pop(value));
+
+	return check_result("pipeline");
+}
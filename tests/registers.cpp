@@ -0,0 +1,94 @@
+/*	Register constants, tracked per instruction and through analyse_program. */
+
+#include <vector>
+
+#include "analysis.h"
+#include "check.h"
+#include "registers.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x45, 0xf9, 0x00, 0xdf, 0xf0, 0x00,		// 1000 LEA $DFF000,A2
+	0x70, 0x05,								// 1006 MOVEQ #5,D0
+	0x35, 0x40, 0x00, 0x96,					// 1008 MOVE.W D0,$96(A2)
+	0x43, 0xf9, 0x00, 0x00, 0x10, 0x20,		// 100c LEA $1020,A1
+	0x4e, 0x91,								// 1012 JSR (A1)
+	0x30, 0x12,								// 1014 MOVE.W (A2),D0
+	0x4e, 0x91,								// 1016 JSR (A1), which the call made unknown
+	0x4e, 0x75,								// 1018 RTS
+	0x4e, 0x71, 0x4e, 0x71, 0x4e, 0x71,		// 101a NOPs
+	0x4e, 0x75								// 1020 RTS
+};
+
+/* Tracks the instructions of code from @c from to @c to. */
+RegisterState track(uint32_t from, uint32_t to)
+{
+	RegisterState state;
+	Dis68k dis(code, code + sizeof(code), 0x1000);
+	Dis68kInstruction inst;
+	dis.seek(from);
+	while( dis.tell() < to && dis.decode(inst) ) track_instruction(state, inst);
+	return state;
+}
+
+}
+
+int main()
+{
+	uint32_t value;
+	RegisterState state = track(0x1000, 0x1012);
+	CHECK(state.get(address_register(2), value) && value == 0xdff000);
+	CHECK(state.get(address_register(1), value) && value == 0x1020);
+	CHECK(state.get(0, value) && value == 5);
+
+	/* Calls forget D0, D1, A0 and A1, and keep the rest. */
+	state = track(0x1000, 0x1014);
+	CHECK(!state.get(address_register(1), value) && !state.get(0, value));
+	CHECK(state.get(address_register(2), value) && value == 0xdff000);
+
+	/* Simple arithmetic on a known value. */
+	const uint8_t addq[] = { 0x70, 0x05, 0x52, 0x80 };		// MOVEQ #5,D0; ADDQ.L #1,D0
+	Dis68k dis(addq, addq + sizeof(addq), 0);
+	Dis68kInstruction inst;
+	RegisterState arithmetic;
+	while( dis.tell() < sizeof(addq) && dis.decode(inst) ) track_instruction(arithmetic, inst);
+	CHECK(arithmetic.get(0, value) && value == 6);
+
+	/* -(An) addresses below An by the access size. */
+	RegisterState pointer;
+	pointer.set(address_register(3), 0x100);
+	Dis68kOperand pre = Dis68kOperand();
+	pre.mode = ModePreDecrement;
+	pre.reg = 3;
+	CHECK(effective_address(pointer, pre, SizeLong, value) && value == 0xfc);
+	pre.reg = 4;
+	CHECK(!effective_address(pointer, pre, SizeLong, value));
+
+	/* meet keeps only what both sides agree on. */
+	RegisterState left, right;
+	left.set(1, 7);
+	left.set(2, 8);
+	right.set(1, 7);
+	right.set(2, 9);
+	left.meet(right);
+	CHECK(left.get(1, value) && value == 7 && !left.get(2, value));
+
+	/* The same, found by analysis: references, and a function called through A1. */
+	Program program;
+	CHECK(analyse_program(code, code + sizeof(code), 0x1000, std::vector<uint32_t>(1, 0x1000), program, 1));
+	CHECK(program.references.size() == 3);
+	if( program.references.size() == 3 )
+	{
+		const Reference &store = program.references[0], &call = program.references[1], &load = program.references[2];
+		CHECK(store.instruction == 0x1008 && store.operand == 1 && store.target == 0xdff096 && store.kind == ReferenceData);
+		CHECK(call.instruction == 0x1012 && call.operand == 0 && call.target == 0x1020 && call.kind == ReferenceCall);
+		CHECK(load.instruction == 0x1014 && load.operand == 0 && load.target == 0xdff000 && load.kind == ReferenceData);
+	}
+
+	const long callee = program.find_function(0x1020);
+	CHECK(callee >= 0);
+	if( callee >= 0 ) CHECK(program.functions[callee].origin == ( OriginRegister | OriginCall ));
+
+	return check_result("registers");
+}
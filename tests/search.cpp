@@ -0,0 +1,86 @@
+/*	Pattern search: short and long absolute addresses, opcodes, and slices. */
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "search.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x4e, 0x71,								// 1000 NOP
+	0x4e, 0xb8, 0x80, 0x00,					// 1002 JSR $8000.W, which is $FF8000
+	0x4e, 0xb9, 0x00, 0xff, 0x80, 0x00,		// 1006 JSR $FF8000
+	0x4e, 0xb9, 0x00, 0x00, 0x80, 0x00,		// 100c JSR $8000
+	0x31, 0xc0, 0x80, 0x04,					// 1012 MOVE.W D0,$8004.W
+	0x23, 0xc1, 0x00, 0xff, 0x80, 0x04,		// 1016 MOVE.L D1,$FF8004
+	0x4e, 0xf8, 0x80, 0x00,					// 101c JMP $8000.W
+	0x4e, 0x41								// 1020 TRAP #1
+};
+
+std::vector<PatternMatch> search(const std::vector<uint8_t> &image, uint32_t address, const std::vector<InstructionPattern> &patterns, unsigned int threads)
+{
+	std::vector<PatternMatch> matches;
+	find_patterns(image.data(), image.data() + image.size(), address, patterns, matches, threads);
+	return matches;
+}
+
+bool same(const std::vector<PatternMatch> &a, const std::vector<PatternMatch> &b)
+{
+	if( a.size() != b.size() ) return false;
+	for( size_t k = 0; k < a.size(); ++k )
+	{
+		if( a[k].address != b[k].address || a[k].pattern != b[k].pattern ) return false;
+	}
+	return true;
+}
+
+}
+
+int main()
+{
+	std::vector<InstructionPattern> patterns;
+	patterns.push_back(call_pattern(0xff8000));
+	patterns.push_back(store_pattern(0xff8004));
+	patterns.push_back(opcode_pattern(OpTRAP));
+	patterns.push_back(call_pattern(0xffff8000, true, 0xffffffff));
+
+	const std::vector<uint8_t> image(code, code + sizeof(code));
+	const std::vector<PatternMatch> matches = search(image, 0x1000, patterns, 1);
+	const PatternMatch expected[] = {
+		{0x1002, 0}, {0x1006, 0},			// both encodings of the call, not the one to $008000
+		{0x1012, 1}, {0x1016, 1},
+		{0x101c, 3},						// the full mask only matches the sign-extended short address
+		{0x1020, 2}
+	};
+	CHECK(same(matches, std::vector<PatternMatch>(expected, expected + 6)));
+
+	/* Under the full mask, the long call to $FF8000 is a different address. */
+	std::vector<InstructionPattern> exact(1, call_pattern(0xff8000, false, 0xffffffff));
+	const std::vector<PatternMatch> long_only = search(image, 0x1000, exact, 1);
+	CHECK(long_only.size() == 1 && long_only[0].address == 0x1006);
+
+	/* Copies across several slices, at an odd offset into the vector width, find the same. */
+	std::vector<uint8_t> large;
+	std::vector<PatternMatch> repeated;
+	for( uint32_t copy = 0; copy < 20000; ++copy )
+	{
+		const uint32_t base = 0x1000 + uint32_t(large.size());
+		large.insert(large.end(), code, code + sizeof(code));
+		for( const PatternMatch &match : expected ) repeated.push_back(PatternMatch{base + match.address - 0x1000, match.pattern});
+	}
+	CHECK(same(search(large, 0x1000, patterns, 4), repeated));
+
+	FILE *out = tmpfile();
+	CHECK(write_pattern_matches(code, code + sizeof(code), 0x1000, matches, out));
+	rewind(out);
+	std::string text;
+	char line[256];
+	while( fgets(line, sizeof(line), out) ) text += line;
+	fclose(out);
+	CHECK(text.find("00001002\tJSR      $00008000\t; pattern 0\n") != std::string::npos);
+	CHECK(text.find("00001020\tTRAP     #1\t; pattern 2\n") != std::string::npos);
+
+	return check_result("search");
+}
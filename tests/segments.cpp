@@ -0,0 +1,55 @@
+/*	Segmented address spaces: reads across pages, gaps and overlaps, and branches between segments. */
+
+#include <vector>
+
+#include "check.h"
+#include "listing.h"
+
+int main()
+{
+	/* Code in a low bank branches to a routine in a high one. */
+	const uint8_t low[] = {
+		0x61, 0x00, 0x0f, 0xfe,		// BSR $2000
+		0x4e, 0x75					// RTS
+	};
+	const uint8_t high[] = {
+		0x70, 0x01,					// MOVEQ #1,D0
+		0x4e, 0x75					// RTS
+	};
+	std::vector<uint8_t> straddling(0x20);
+	for( size_t k = 0; k < straddling.size(); ++k ) straddling[k] = uint8_t(k);
+
+	SegmentedImage image;
+	CHECK(image.add_segment(low, low + sizeof(low), 0x1000));
+	CHECK(image.add_segment(high, high + sizeof(high), 0x2000));
+	CHECK(image.add_segment(straddling.data(), straddling.data() + straddling.size(), 0x5ff0));
+	CHECK(!image.add_segment(low, low + sizeof(low), 0xfffffe));
+	CHECK(image.segments().size() == 3);
+
+	/* Words straddling a page boundary, and the 68000's ignored top byte. */
+	uint16_t word;
+	uint8_t byte;
+	CHECK(image.word(0x5fff, word) && word == 0x0f10);
+	CHECK(image.word(0xff005ff0, word) && word == 0x0001);
+	CHECK(!image.byte(0x1006, byte));
+	CHECK(!image.word(0x1fff, word));
+	CHECK(!image.contains(0x3000));
+	CHECK(image.contains(0x6000));
+
+	/* A later segment wins where two overlap. */
+	const uint8_t patch[] = { 0x4e, 0x71 };
+	CHECK(image.add_segment(patch, patch + sizeof(patch), 0x1004));
+	CHECK(image.word(0x1004, word) && word == 0x4e71);
+	CHECK(image.word(0x1002, word) && word == 0x0ffe);
+
+	BasicDis68k<SegmentedView> dis(SegmentedView(image), 0x1000);
+	Dis68kInstruction inst;
+	CHECK(dis.decode(inst) && inst.has_target && inst.target == 0x2000);
+	CHECK(dis.seek(inst.target));
+	char line[kMaxListingLine];
+	listing_line<MotorolaSyntax>(dis, line, sizeof(line));
+	CHECK_STRING(line, "00002000\tMOVEQ    #$01,D0\n");
+	CHECK(!dis.seek(0x3000));
+
+	return check_result("segments");
+}
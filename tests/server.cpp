@@ -0,0 +1,166 @@
+/*	The resident server, over its socket: answers, partial requests, and clients that don't read. */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "listing.h"
+#include "server.h"
+
+namespace {
+
+/* A reset handler at $100 that calls $120. */
+std::vector<uint8_t> make_image()
+{
+	std::vector<uint8_t> image(0x4000, 0);
+	const uint8_t vectors[] = { 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00 };
+	const uint8_t code[] = {
+		0x4e, 0xb9, 0x00, 0x00, 0x01, 0x20,		// 100 JSR $120
+		0x60, 0xf8								// 106 BRA $100
+	};
+	const uint8_t callee[] = {
+		0x70, 0x01,								// 120 MOVEQ #1,D0
+		0x4e, 0x75								// 122 RTS
+	};
+	std::copy(vectors, vectors + sizeof(vectors), image.begin());
+	std::copy(code, code + sizeof(code), image.begin() + 0x100);
+	std::copy(callee, callee + sizeof(callee), image.begin() + 0x120);
+	for( size_t k = 0x200; k < image.size(); k += 2 ) image[k] = 0x4e, image[k + 1] = 0x71;
+	return image;
+}
+
+int connect_to(const std::string &path)
+{
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un name;
+	memset(&name, 0, sizeof(name));
+	name.sun_family = AF_UNIX;
+	strcpy(name.sun_path, path.c_str());
+	CHECK(fd >= 0 && connect(fd, (struct sockaddr *)&name, sizeof(name)) == 0);
+	return fd;
+}
+
+ServerRequest request_of(uint32_t type, uint32_t address, uint32_t count = 0)
+{
+	ServerRequest request = { type, 0, address, count, uint32_t(OutputSyntax::Motorola) };
+	return request;
+}
+
+/* @returns Whether a RequestSymbol for $120 on @c fd is answered with "init". */
+bool answers_symbol(int fd)
+{
+	ServerResponse response;
+	std::vector<char> payload;
+	return server_call(fd, request_of(RequestSymbol, 0x120), response, payload) &&
+		response.status == StatusOK && std::string(payload.begin(), payload.end()) == "init";
+}
+
+bool receive(int fd, void *data, size_t length)
+{
+	for( char *next = (char *)data; length; )
+	{
+		const ssize_t got = recv(fd, next, length, 0);
+		if( got <= 0 ) return false;
+		next += got;
+		length -= size_t(got);
+	}
+	return true;
+}
+
+}
+
+int main()
+{
+	/* A failure should be reported, not end the test. */
+	signal(SIGPIPE, SIG_IGN);
+
+	char directory[] = "/tmp/dis68k-server-XXXXXX";
+	CHECK(mkdtemp(directory));
+	const std::string image_path = std::string(directory) + "/image", symbols_path = std::string(directory) + "/symbols";
+	const std::string socket_path = std::string(directory) + "/socket";
+
+	const std::vector<uint8_t> image = make_image();
+	FILE *file = fopen(image_path.c_str(), "wb");
+	fwrite(image.data(), 1, image.size(), file);
+	fclose(file);
+	file = fopen(symbols_path.c_str(), "w");
+	fputs("init = $120\n", file);
+	fclose(file);
+
+	DisassemblyServer server;
+	CHECK(server.add_image(image_path.c_str(), 0, symbols_path.c_str()) == 0);
+	CHECK(server.listen(socket_path.c_str()));
+
+	/* One thread, so that a client holding it would stall every other. */
+	std::thread serving([&server] { server.serve(1); });
+
+	const int fd = connect_to(socket_path);
+	ServerResponse response;
+	std::vector<char> payload;
+
+	CHECK(server_call(fd, request_of(RequestImage, 0), response, payload) && response.status == StatusOK);
+	ServerImageInfo info;
+	CHECK(payload.size() == sizeof(info));
+	memcpy(&info, payload.data(), sizeof(info));
+	CHECK(info.address == 0 && info.size == image.size() && info.symbols == 1);
+
+	/* Listings start at the instruction containing the address. */
+	CHECK(server_call(fd, request_of(RequestListing, 0x104, 2), response, payload) && response.status == StatusOK);
+	CHECK(std::string(payload.begin(), payload.end()) == "00000100\tJSR      init\n00000106\tBRA      $00000100\n");
+
+	CHECK(server_call(fd, request_of(RequestFunction, 0x122), response, payload) && response.status == StatusOK);
+	ServerFunctionInfo function;
+	CHECK(payload.size() == sizeof(function));
+	memcpy(&function, payload.data(), sizeof(function));
+	CHECK(function.entry == 0x120 && function.block_start == 0x120 && function.block_end == 0x124);
+
+	CHECK(answers_symbol(fd));
+	CHECK(server_call(fd, request_of(RequestSymbol, 0x122), response, payload) && response.status == StatusNotFound);
+	CHECK(server_call(fd, request_of(RequestListing, 0, kMaxServerListing + 1), response, payload) && response.status == StatusBadRequest);
+	ServerRequest missing = request_of(RequestImage, 0);
+	missing.image = 1;
+	CHECK(server_call(fd, missing, response, payload) && response.status == StatusNoImage && payload.empty());
+
+	/* A request sent in pieces holds no thread while it is incomplete. */
+	const int slow = connect_to(socket_path);
+	const ServerRequest split = request_of(RequestSymbol, 0x120);
+	CHECK(send(slow, &split, 7, 0) == 7);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(answers_symbol(fd));
+	CHECK(send(slow, (const char *)&split + 7, sizeof(split) - 7, 0) == ssize_t(sizeof(split) - 7));
+	CHECK(receive(slow, &response, sizeof(response)) && response.status == StatusOK && response.length == 4);
+	char name[4];
+	CHECK(receive(slow, name, sizeof(name)) && !memcmp(name, "init", 4));
+
+	/* Nor does a response larger than the socket takes, to a client that isn't reading, or requests sent together. */
+	const ServerRequest large[2] = { request_of(RequestListing, 0x200, kMaxServerListing), request_of(RequestListing, 0x200, kMaxServerListing) };
+	CHECK(send(slow, large, sizeof(large), 0) == ssize_t(sizeof(large)));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(answers_symbol(fd));
+	for( int k = 0; k < 2; ++k )
+	{
+		CHECK(receive(slow, &response, sizeof(response)) && response.status == StatusOK);
+		std::vector<char> text(response.length);
+		CHECK(receive(slow, text.data(), text.size()));
+		CHECK(std::count(text.begin(), text.end(), '\n') == kMaxServerListing);
+	}
+
+	close(slow);
+	close(fd);
+	server.stop();
+	serving.join();
+
+	unlink(image_path.c_str());
+	unlink(symbols_path.c_str());
+	rmdir(directory);
+	return check_result("server");
+}
@@ -0,0 +1,150 @@
+/*	MinHash signatures, and an index built, reopened and queried. */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "similarity.h"
+
+namespace {
+
+/* Twelve instructions in one block. */
+const uint16_t function[] = {
+	0x7001, 0x7202, 0xd081, 0x2400, 0xe54a, 0xd082,	// MOVEQ #1,D0; MOVEQ #2,D1; ADD.L D1,D0; MOVE.L D0,D2; LSL.W #2,D2; ADD.L D2,D0
+	0x7603, 0x9083, 0x4680, 0x4480, 0x4281, 0x4e75		// MOVEQ #3,D3; SUB.L D3,D0; NOT.L D0; NEG.L D0; CLR.L D1; RTS
+};
+
+void put_word(std::vector<uint8_t> &image, uint32_t offset, uint16_t word)
+{
+	image[offset] = uint8_t(word >> 8);
+	image[offset + 1] = uint8_t(word);
+}
+
+void put_long(std::vector<uint8_t> &image, uint32_t offset, uint32_t value)
+{
+	put_word(image, offset, uint16_t(value >> 16));
+	put_word(image, offset + 2, uint16_t(value));
+}
+
+/* An image whose reset handler, at $100, calls each of @c callees and returns. */
+std::vector<uint8_t> image_calling(const std::vector<uint32_t> &callees)
+{
+	std::vector<uint8_t> image(0x400, 0);
+	put_long(image, 0, 0x00ff0000);
+	put_long(image, 4, 0x100);
+	uint32_t at = 0x100;
+	for( uint32_t callee : callees )
+	{
+		put_word(image, at, 0x4eb9);
+		put_long(image, at + 2, callee);
+		at += 6;
+	}
+	put_word(image, at, 0x4e75);
+	return image;
+}
+
+std::string write_temporary(const std::vector<uint8_t> &data, const char *suffix)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/dis68k-%s-XXXXXX", suffix);
+	const int fd = mkstemp(path);
+	CHECK(fd >= 0);
+	CHECK(write(fd, data.data(), data.size()) == ssize_t(data.size()));
+	close(fd);
+	return path;
+}
+
+}
+
+int main()
+{
+	/* The first image has the function; the second a copy with one register changed, and eleven NOPs. */
+	std::vector<uint8_t> first = image_calling(std::vector<uint32_t>(1, 0x120));
+	for( size_t k = 0; k < 12; ++k ) put_word(first, 0x120 + 2 * k, function[k]);
+
+	std::vector<uint32_t> callees;
+	callees.push_back(0x140);
+	callees.push_back(0x180);
+	std::vector<uint8_t> second = image_calling(callees);
+	for( size_t k = 0; k < 12; ++k ) put_word(second, 0x140 + 2 * k, function[k]);
+	put_word(second, 0x140 + 2 * 10, 0x4282);		// CLR.L D2
+	for( size_t k = 0; k < 11; ++k ) put_word(second, 0x180 + 2 * k, 0x4e71);
+	put_word(second, 0x180 + 2 * 11, 0x4e75);
+
+	Program program;
+	CHECK(analyse_program(first.data(), first.data() + first.size(), 0, std::vector<uint32_t>(1, 0x100), program, 1));
+	const long f = program.find_function(0x120);
+	CHECK(f >= 0);
+	FunctionSignature signature;
+	CHECK(f >= 0 && function_signature(first.data(), first.data() + first.size(), 0, program, uint32_t(f), 0, signature));
+	CHECK(signature.instructions == 12);
+	CHECK(signature_similarity(signature, signature) == 1.0);
+
+	/* The caller is too short to index. */
+	FunctionSignature caller;
+	CHECK(!function_signature(first.data(), first.data() + first.size(), 0, program, uint32_t(program.find_function(0x100)), 0, caller));
+
+	std::vector<IndexSource> sources(2);
+	sources[0].path = write_temporary(first, "first");
+	sources[0].address = 0;
+	sources[1].path = write_temporary(second, "second");
+	sources[1].address = 0;
+	const std::string index_path = write_temporary(std::vector<uint8_t>(), "index");
+	CHECK(build_similarity_index(sources, index_path.c_str(), 0, 2));
+
+	SimilarityIndex index;
+	CHECK(index.open(index_path.c_str()));
+	CHECK(index.flags() == 0);
+	CHECK(index.file_count() == 2 && index.function_count() == 3);
+	if( index.file_count() == 2 && index.function_count() == 3 )
+	{
+		CHECK_STRING(index.file_path(0), sources[0].path.c_str());
+		CHECK_STRING(index.file_path(1), sources[1].path.c_str());
+		CHECK(index.file_address(1) == 0);
+
+		/* Signatures come back as they were computed. */
+		long stored = -1;
+		for( uint32_t k = 0; k < index.function_count(); ++k )
+		{
+			const IndexedFunction &indexed = index.function(k);
+			if( indexed.file == 0 && indexed.entry == 0x120 ) stored = long(k);
+		}
+		CHECK(stored >= 0);
+		if( stored >= 0 )
+		{
+			CHECK(index.function(uint32_t(stored)).instructions == 12 && index.function(uint32_t(stored)).blocks == 1);
+			const FunctionSignature copy = index.signature(uint32_t(stored));
+			CHECK(!memcmp(copy.minhash, signature.minhash, sizeof(signature.minhash)));
+		}
+
+		/* The function itself, then its near copy; the NOPs don't come close. */
+		std::vector<SimilarityMatch> matches;
+		index.query(signature, 10, 0.5, matches);
+		CHECK(matches.size() == 2);
+		if( matches.size() == 2 )
+		{
+			CHECK(matches[0].function == uint32_t(stored) && matches[0].similarity == 1.0);
+			const IndexedFunction &copy = index.function(matches[1].function);
+			CHECK(copy.file == 1 && copy.entry == 0x140);
+			CHECK(matches[1].similarity >= 0.5 && matches[1].similarity < 1.0);
+		}
+	}
+	index.close();
+
+	/* An index of no images opens, and matches nothing. */
+	CHECK(build_similarity_index(std::vector<IndexSource>(), index_path.c_str(), 0, 2));
+	CHECK(index.open(index_path.c_str()));
+	CHECK(index.file_count() == 0 && index.function_count() == 0);
+	std::vector<SimilarityMatch> none;
+	index.query(signature, 10, 0.0, none);
+	CHECK(none.empty());
+	index.close();
+
+	unlink(sources[0].path.c_str());
+	unlink(sources[1].path.c_str());
+	unlink(index_path.c_str());
+	return check_result("similarity");
+}
@@ -0,0 +1,100 @@
+/*	The columnar store gives back the instructions put into it. */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "store.h"
+
+namespace {
+
+bool same_operand(const Dis68kOperand &a, const Dis68kOperand &b)
+{
+	return a.mode == b.mode && a.reg == b.reg && a.index == b.index && a.displacement == b.displacement && a.value == b.value;
+}
+
+bool same_instruction(const Dis68kInstruction &a, const Dis68kInstruction &b)
+{
+	if( a.address != b.address || a.opcode != b.opcode || a.opnum != b.opnum || a.length != b.length ) return false;
+	if( a.size != b.size || a.flow != b.flow || a.condition != b.condition || a.operand_count != b.operand_count ) return false;
+	if( a.has_target != b.has_target || ( a.has_target && a.target != b.target ) ) return false;
+	for( unsigned int k = 0; k < a.operand_count; ++k )
+	{
+		if( !same_operand(a.operands[k], b.operands[k]) ) return false;
+	}
+	return true;
+}
+
+}
+
+int main()
+{
+	/* Arbitrary words give every mode, and gaps where words don't decode. */
+	std::vector<uint8_t> image(256 * 1024 + 1);
+	srand(68000);
+	for( uint8_t &byte : image ) byte = uint8_t(rand() >> 4);
+	const uint32_t address = 0xfc0000;
+
+	/* What store_listing keeps: each instruction that decodes, in listing order. */
+	std::vector<Dis68kInstruction> expected;
+	Dis68k dis(image.data(), image.data() + image.size(), address);
+	const uint32_t end_address = address + uint32_t(image.size());
+	Dis68kInstruction inst;
+	while( dis.tell() < end_address )
+	{
+		const uint32_t at = dis.tell();
+		if( dis.decode(inst) && !dis.overflowed() )
+		{
+			expected.push_back(inst);
+			continue;
+		}
+		dis.seek(at + ( end_address - at >= 2 ? 2 : 1 ));
+	}
+
+	InstructionStore store;
+	store_listing(image.data(), image.data() + image.size(), address, store);
+	CHECK(store.size() == expected.size());
+	CHECK(store.size() > 2 * InstructionStore::kStoreCheckpointInterval);
+	CHECK(store.memory() < expected.size() * sizeof(Dis68kInstruction) / 4);
+
+	/* In order, by iteration. */
+	size_t index = 0, mismatches = 0;
+	for( InstructionStore::const_iterator it = store.begin(); it != store.end() && index < expected.size(); ++it, ++index )
+	{
+		if( !same_instruction(*it, expected[index]) || it.position() != index ) ++mismatches;
+	}
+	CHECK(index == expected.size() && mismatches == 0);
+
+	/* At random, by index and from iterators part way through a checkpoint interval. */
+	for( int k = 0; k < 2000; ++k )
+	{
+		const size_t i = size_t(rand()) % expected.size();
+		if( !same_instruction(store[i], expected[i]) ) ++mismatches;
+
+		InstructionStore::const_iterator it = store.iterator_at(i);
+		for( size_t j = i; j < std::min(expected.size(), i + 3); ++j, ++it )
+		{
+			if( !same_instruction(*it, expected[j]) ) ++mismatches;
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(store.iterator_at(store.size()) == store.end());
+
+	/* lower_bound finds each instruction by its address, and the next one from within it. */
+	for( int k = 0; k < 2000; ++k )
+	{
+		const size_t i = size_t(rand()) % expected.size();
+		if( store.lower_bound(expected[i].address) != i ) ++mismatches;
+		if( i + 1 < expected.size() && store.lower_bound(expected[i].address + 1) != i + 1 ) ++mismatches;
+	}
+	CHECK(mismatches == 0);
+	CHECK(store.lower_bound(0) == 0);
+	CHECK(store.lower_bound(end_address) == store.size());
+
+	store.clear();
+	CHECK(store.size() == 0 && store.begin() == store.end() && store.lower_bound(address) == 0);
+
+	return check_result("store");
+}
@@ -0,0 +1,95 @@
+/*	Symbol files, lookups under the address mask, and symbolic listings. */
+
+#include <unistd.h>
+
+#include <string>
+
+#include "check.h"
+#include "symbols.h"
+
+namespace {
+
+const char symbol_file[] =
+	"; Amiga custom chips\n"
+	"* a comment\n"
+	"# another\n"
+	"DMACON EQU $DFF096\n"
+	"COLOR00 = 0xDFF180\t; background\n"
+	"COUNT = 42\n"
+	"00FC0000 T _start\n"
+	"00fc0010 t loop\n"
+	"00fc000c t a_name_of_sixty_five_characters_which_is_one_more_than_the_limit_\n"
+	"not a symbol\n";
+
+const uint8_t code[] = {
+	0x33, 0xfc, 0x82, 0x00, 0x00, 0xdf, 0xf0, 0x96,	// fc0000 MOVE.W #$8200,$DFF096
+	0x4e, 0xb8, 0x80, 0x00,							// fc0008 JSR $8000.W
+	0x4e, 0x71, 0x4e, 0x71,							// fc000c NOPs
+	0x60, 0xfe										// fc0010 BRA $FC0010
+};
+
+}
+
+int main()
+{
+	char path[] = "/tmp/dis68k-symbols-XXXXXX";
+	const int fd = mkstemp(path);
+	CHECK(fd >= 0 && write(fd, symbol_file, sizeof(symbol_file) - 1) == ssize_t(sizeof(symbol_file) - 1));
+	close(fd);
+
+	SymbolTable symbols;
+	CHECK(symbols.load(path));
+	unlink(path);
+	symbols.add(0xff8000, "vblank");
+	symbols.add(0xdff096, "dmacon");			// the first name given is kept
+	symbols.build();
+
+	CHECK(symbols.size() == 6);
+	CHECK(symbols.find(0xdff096) && !strcmp(symbols.find(0xdff096), "DMACON"));
+	CHECK(symbols.find(0xdff180) && !strcmp(symbols.find(0xdff180), "COLOR00"));
+	CHECK(symbols.find(42) && !strcmp(symbols.find(42), "COUNT"));
+	CHECK(symbols.find(0xfc0010) && !strcmp(symbols.find(0xfc0010), "loop"));
+	CHECK(!symbols.find(0xdff098) && !symbols.find(0xfc0000 + 0x10000) && !symbols.find(0xfc000c));
+
+	/* The top byte is ignored, so sign-extended short addresses find their names. */
+	CHECK(symbols.find(0xffff8000) && !strcmp(symbols.find(0xffff8000), "vblank"));
+	CHECK(symbols.find(0xffdff096) && !strcmp(symbols.find(0xffdff096), "DMACON"));
+
+	Dis68k dis(code, code + sizeof(code), 0xfc0000);
+	char line[kMaxListingLine];
+	symbolic_listing_line<MotorolaSyntax>(dis, symbols, line, sizeof(line));
+	CHECK_STRING(line, "00fc0000\tMOVE.W   #$8200,DMACON\n");
+	symbolic_listing_line<MotorolaSyntax>(dis, symbols, line, sizeof(line));
+	CHECK_STRING(line, "00fc0008\tJSR      vblank.W\n");
+
+	FILE *out = tmpfile();
+	CHECK(write_symbolic_listing(code, code + sizeof(code), 0xfc0000, symbols, out, OutputSyntax::DevpacLower));
+	rewind(out);
+	std::string text;
+	while( fgets(line, sizeof(line), out) ) text += line;
+	fclose(out);
+	CHECK_STRING(text.c_str(),
+		"_start:\n"
+		"00fc0000\t\tmove.w\t#$8200,DMACON\n"
+		"00fc0008\t\tjsr\tvblank.w\n"
+		"00fc000c\t\tnop\n"
+		"00fc000e\t\tnop\n"
+		"loop:\n"
+		"00fc0010\t\tbra\tloop\n");
+
+	/* Names as long as the table accepts are printed whole; longer ones are refused. */
+	const std::string longest(kMaxSymbolName, 'x');
+	SymbolTable long_names;
+	CHECK(long_names.add(0xdff096, longest.c_str()) && long_names.add(0xff8000, longest.c_str()));
+	CHECK(!long_names.add(0xfc0010, (longest + "x").c_str()));
+	long_names.build();
+	CHECK(long_names.size() == 2);
+	dis.seek(0xfc0000);
+	const std::string move = "00fc0000\tMOVE.W   #$8200," + longest + "\n", jsr = "00fc0008\t\tjsr\t" + longest + ".w\n";
+	symbolic_listing_line<MotorolaSyntax>(dis, long_names, line, sizeof(line));
+	CHECK_STRING(line, move.c_str());
+	symbolic_listing_line<GnuSyntax>(dis, long_names, line, sizeof(line));
+	CHECK_STRING(line, jsr.c_str());
+
+	return check_result("symbols");
+}
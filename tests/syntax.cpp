@@ -0,0 +1,92 @@
+/*	Known-answer listings in each output syntax. */
+
+#include "check.h"
+#include "listing.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x2f, 0x00,								// MOVE.L D0,-(A7)
+	0x41, 0xfa, 0x00, 0x0e,					// LEA 14(PC),A0
+	0x4e, 0x71,								// NOP
+	0x4e, 0xb9, 0x00, 0xdf, 0xf0, 0x96,		// JSR $DFF096
+	0xff, 0xff,								// not an instruction
+	0x48, 0xe7, 0xc0, 0xc0,					// MOVEM.L D0-D1/A0-A1,-(A7)
+	0x02, 0x3c, 0x00, 0x0f,					// ANDI.B #$0F,CCR
+	0x4e, 0x4f,								// TRAP #15
+	0x67, 0x00, 0xff, 0xec,					// BEQ $1008
+	0x4e									// a trailing odd byte
+};
+
+template<typename Syntax>
+void check_listing(const char *const *expected, size_t count)
+{
+	Dis68k dis(code, code + sizeof(code), 0x1000);
+	char line[kMaxListingLine];
+	for( size_t k = 0; k < count; ++k )
+	{
+		listing_line<Syntax>(dis, line, sizeof(line));
+		CHECK_STRING(line, expected[k]);
+	}
+	CHECK(dis.tell() == 0x1000 + sizeof(code));
+}
+
+const char *const motorola[] = {
+	"00001000\tMOVE.L   D0,-(A7)\n",
+	"00001002\tLEA      +14(PC) {$00001012},A0\n",
+	"00001006\tNOP\n",
+	"00001008\tJSR      $00dff096\n",
+	"0000100e\tDC.W     $FFFF\n",
+	"00001010\tMOVEM.L  D0/D1/A0/A1,-(A7)\n",
+	"00001014\tANDI.B   #$0F,CCR\n",
+	"00001018\tTRAP     #15\n",
+	"0000101a\tBEQ      $00001008\n",
+	"0000101e\tDC.B     $4E\n"
+};
+
+const char *const devpac_lower[] = {
+	"00001000\t\tmove.l\td0,-(a7)\n",
+	"00001002\t\tlea\t+14(pc) {$00001012},a0\n",
+	"00001006\t\tnop\n",
+	"00001008\t\tjsr\t$00dff096\n",
+	"0000100e\t\tdc.w\t$FFFF\n",
+	"00001010\t\tmovem.l\td0/d1/a0/a1,-(a7)\n",
+	"00001014\t\tandi.b\t#$0F,ccr\n",
+	"00001018\t\ttrap\t#15\n",
+	"0000101a\t\tbeq\t$00001008\n",
+	"0000101e\t\tdc.b\t$4E\n"
+};
+
+const char *const gnu[] = {
+	"00001000\t\tmove.l\t%d0,-(%a7)\n",
+	"00001002\t\tlea\t+14(%pc),%a0\n",
+	"00001006\t\tnop\n",
+	"00001008\t\tjsr\t0x00dff096\n",
+	"0000100e\t\t.short\t0xFFFF\n",
+	"00001010\t\tmovem.l\t%d0/%d1/%a0/%a1,-(%a7)\n",
+	"00001014\t\tandi.b\t#0x0F,%ccr\n",
+	"00001018\t\ttrap\t#15\n",
+	"0000101a\t\tbeq\t0x00001008\n",
+	"0000101e\t\t.byte\t0x4E\n"
+};
+
+}
+
+int main()
+{
+	const size_t count = sizeof(motorola) / sizeof(motorola[0]);
+	check_listing<MotorolaSyntax>(motorola, count);
+	check_listing<DevpacLowerSyntax>(devpac_lower, count);
+	check_listing<GnuSyntax>(gnu, count);
+
+	/* The runtime selection picks the same specialisation. */
+	Dis68k dis(code, code + sizeof(code), 0x1000);
+	Dis68k::DisasmFn disasm = Dis68k::disasm_for(OutputSyntax::Gnu);
+	uint32_t address;
+	char text[64];
+	CHECK((dis.*disasm)(&address, text, sizeof(text)));
+	CHECK(address == 0x1000);
+	CHECK_STRING(text, "\tmove.l\t%d0,-(%a7)\n");
+
+	return check_result("syntax");
+}
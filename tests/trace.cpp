@@ -0,0 +1,74 @@
+/*	Trace profiles: counting, and code entries after jumps and returns. */
+
+#include <vector>
+
+#include "analysis.h"
+#include "check.h"
+#include "trace.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x70, 0x01,								// 1000 MOVEQ #1,D0
+	0x4e, 0x71,								// 1002 NOP
+	0x4e, 0x75,								// 1004 RTS
+	0x70, 0x02,								// 1006 MOVEQ #2,D0, straight after a return
+	0x60, 0x02,								// 1008 BRA $100c
+	0x4e, 0x71,								// 100a NOP, never executed
+	0x4e, 0x71,								// 100c NOP, straight after a jump
+	0x4e, 0x75,								// 100e RTS
+	0x4e, 0x71, 0x4e, 0x71,					// 1010 NOPs, never executed
+	0x4e, 0x75								// 1014 RTS
+};
+
+const uint32_t pcs[] = {
+	0x1000, 0x1002, 0x1004, 0x1006, 0x1008, 0x100c, 0x100e, 0x1014,
+	0x1000, 0x1000, 0x1001, 0x2000
+};
+
+}
+
+int main()
+{
+	const uint32_t address = 0x1000;
+	TraceProfile profile(address, sizeof(code));
+	profile.add(pcs, sizeof(pcs) / sizeof(pcs[0]), TraceByteOrder::LittleEndian, 4);
+	CHECK(profile.total() == 12 && profile.outside() == 2);
+	CHECK(profile.hits(0x1000) == 3 && profile.hits(0x1002) == 1 && profile.hits(0x100a) == 0);
+
+	/* The same counters, mapped from a file, and from big-endian program counters. */
+	FILE *file = tmpfile();
+	for( uint32_t pc : pcs ) fwrite(&pc, 4, 1, file);
+	fflush(file);
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fileno(file));
+	TraceProfile loaded(address, sizeof(code));
+	CHECK(loaded.load(path, TraceByteOrder::LittleEndian, 2));
+	CHECK(loaded.total() == 12 && loaded.hits(0x1000) == 3 && loaded.hits(0x1014) == 1);
+	fclose(file);
+
+	std::vector<uint32_t> swapped;
+	for( uint32_t pc : pcs ) swapped.push_back(__builtin_bswap32(pc));
+	TraceProfile big(address, sizeof(code));
+	big.add(swapped.data(), swapped.size(), TraceByteOrder::BigEndian);
+	CHECK(big.hits(0x1000) == 3 && big.outside() == 2);
+
+	/* A trace long enough to be shared between workers, whose counts all reach the totals. */
+	std::vector<uint32_t> repeated;
+	for( int i = 0; i < 1 << 18; ++i ) repeated.insert(repeated.end(), pcs, pcs + 12);
+	TraceProfile shared(address, sizeof(code));
+	shared.add(repeated.data(), repeated.size(), TraceByteOrder::LittleEndian, 3);
+	CHECK(shared.total() == 12u << 18 && shared.outside() == 2u << 18);
+	CHECK(shared.hits(0x1000) == 3u << 18 && shared.hits(0x1014) == 1u << 18);
+
+	/* Whatever follows a return or a jump starts anew; what straight-line decoding reaches doesn't. */
+	const uint32_t all[] = { 0x1000, 0x1006, 0x100c, 0x1014 };
+	CHECK(profile.code_entries(code, code + sizeof(code), nullptr) == std::vector<uint32_t>(all, all + 4));
+
+	Program program;
+	CHECK(analyse_program(code, code + sizeof(code), address, std::vector<uint32_t>(1, address), program, 1));
+	const uint32_t uncovered[] = { 0x1006, 0x100c, 0x1014 };
+	CHECK(profile.code_entries(code, code + sizeof(code), &program) == std::vector<uint32_t>(uncovered, uncovered + 3));
+
+	return check_result("trace");
+}
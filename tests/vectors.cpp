@@ -0,0 +1,90 @@
+/*	Exception vector tables, with and without a header after them. */
+
+#include <vector>
+
+#include "check.h"
+#include "vectors.h"
+
+namespace {
+
+void put_long(std::vector<uint8_t> &image, uint32_t offset, uint32_t value)
+{
+	image[offset] = uint8_t(value >> 24);
+	image[offset + 1] = uint8_t(value >> 16);
+	image[offset + 2] = uint8_t(value >> 8);
+	image[offset + 3] = uint8_t(value);
+}
+
+/* A cartridge-style image: 64 vectors, a header at $100 and the reset code at $200. */
+std::vector<uint8_t> cartridge()
+{
+	std::vector<uint8_t> image(0x1000, 0);
+	put_long(image, 0, 0x00fffe00);
+	put_long(image, 4, 0x00000200);
+	for( uint32_t number = 2; number < 64; ++number ) put_long(image, number * 4, 0x00000300);
+	put_long(image, 30 * 4, 0x00000280);	// level 6 autovector
+
+	const char header[] = "SEGA MEGA DRIVE (C)SEGA 1990.JAN";
+	for( size_t k = 0; k < sizeof(header) - 1; ++k ) image[0x100 + k] = uint8_t(header[k]);
+	put_long(image, 0x120, 0x00000210);		// header data that looks like a handler
+	return image;
+}
+
+}
+
+int main()
+{
+	/* The reset PC at $200 lies below the 1 KB a full table would take. */
+	{
+		const std::vector<uint8_t> image = cartridge();
+		std::vector<ExceptionVector> vectors;
+		CHECK(read_vector_table(image.data(), image.data() + image.size(), 0, vectors) == 63);
+		CHECK(vectors.size() == 63);
+		CHECK(vectors.front().number == 1 && vectors.front().handler == 0x200);
+		CHECK(vectors.back().number == 63);
+		for( const ExceptionVector &v : vectors ) CHECK(v.handler != 0x210);
+
+		const std::vector<uint32_t> entries = vector_entry_points(vectors);
+		CHECK(entries.size() == 3);
+		CHECK(entries[0] == 0x200 && entries[1] == 0x280 && entries[2] == 0x300);
+	}
+
+	/* Without a header, the table runs on until the lowest handler. */
+	{
+		std::vector<uint8_t> image = cartridge();
+		for( uint32_t number = 64; number < 256; ++number ) put_long(image, number * 4, 0x00000300);
+		std::vector<ExceptionVector> vectors;
+		read_vector_table(image.data(), image.data() + image.size(), 0, vectors);
+		CHECK(vectors.size() == 127);
+		CHECK(vectors.back().number == 127);
+	}
+
+	/* A full table, located high, with the top byte of each vector ignored. */
+	{
+		std::vector<uint8_t> image(0x2000, 0);
+		put_long(image, 4, 0xfffc0400);
+		for( uint32_t number = 2; number < 256; ++number ) put_long(image, number * 4, 0x00fc0800);
+		std::vector<ExceptionVector> vectors;
+		CHECK(read_vector_table(image.data(), image.data() + image.size(), 0xfc0000, vectors) == 255);
+		CHECK(vectors.front().handler == 0xfc0400);
+	}
+
+	/* An implausible reset PC discards the table. */
+	{
+		std::vector<uint8_t> image = cartridge();
+		put_long(image, 4, 0x00000201);
+		std::vector<ExceptionVector> vectors;
+		CHECK(read_vector_table(image.data(), image.data() + image.size(), 0, vectors) == 0);
+		CHECK(vectors.empty());
+	}
+
+	char name[32];
+	vector_name(1, name, sizeof(name));
+	CHECK_STRING(name, "reset PC");
+	vector_name(30, name, sizeof(name));
+	CHECK_STRING(name, "level 6 autovector");
+	vector_name(47, name, sizeof(name));
+	CHECK_STRING(name, "TRAP #15");
+
+	return check_result("vectors");
+}
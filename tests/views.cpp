@@ -0,0 +1,68 @@
+/*	Split and byte-swapped dumps list as the image they were made from. */
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "listing.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x48, 0xe7, 0xc0, 0xc0,					// MOVEM.L D0-D1/A0-A1,-(A7)
+	0x20, 0x39, 0x00, 0xdf, 0xf0, 0x06,		// MOVE.L $DFF006,D0
+	0x66, 0xf4,								// BNE
+	0xff, 0xff,								// not an instruction
+	0x4e, 0x75,								// RTS
+	0x4e, 0xb9, 0x00, 0x01					// JSR, cut short
+};
+
+template<typename View>
+std::string listing(BasicDis68k<View> &dis, uint32_t end)
+{
+	std::string text;
+	char line[kMaxListingLine];
+	while( dis.tell() < end )
+	{
+		listing_line<MotorolaSyntax>(dis, line, sizeof(line));
+		text += line;
+	}
+	return text;
+}
+
+}
+
+int main()
+{
+	const uint32_t base = 0x400, end = base + sizeof(code);
+
+	Dis68k contiguous(code, code + sizeof(code), base);
+	const std::string expected = listing(contiguous, end);
+	CHECK(expected.find("00000400\tMOVEM.L  D0/D1/A0/A1,-(A7)\n") == 0);
+	CHECK(expected.find("00000410\tDC.W     $4EB9\n") != std::string::npos);
+
+	std::vector<uint8_t> even, odd, swapped;
+	for( size_t k = 0; k < sizeof(code); k += 2 )
+	{
+		even.push_back(code[k]);
+		odd.push_back(code[k + 1]);
+		swapped.push_back(code[k + 1]);
+		swapped.push_back(code[k]);
+	}
+
+	BasicDis68k<InterleavedView> interleaved(InterleavedView(even.data(), odd.data(), uint32_t(even.size()), base), base);
+	CHECK(listing(interleaved, end) == expected);
+
+	BasicDis68k<WordSwappedView> word_swapped(WordSwappedView(swapped.data(), swapped.data() + swapped.size(), base), base);
+	CHECK(listing(word_swapped, end) == expected);
+
+	/* Reads outside the image fail, whatever the view. */
+	uint16_t word;
+	uint8_t byte;
+	CHECK(!contiguous.peekword(end, word));
+	CHECK(!interleaved.peekbyte(base - 1, byte));
+	CHECK(word_swapped.peekword(end - 2, word) && word == 0x0001);
+	CHECK(interleaved.peekbyte(base + 1, byte) && byte == 0xe7);
+
+	return check_result("views");
+}
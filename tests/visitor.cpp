@@ -0,0 +1,99 @@
+/*	The decode visitor API: records, operands, targets and invalid words. */
+
+#include <vector>
+
+#include "check.h"
+#include "dis68k.h"
+
+namespace {
+
+const uint8_t code[] = {
+	0x32, 0x28, 0x00, 0x10,					// 1000 MOVE.W 16(A0),D1
+	0x4e, 0xb9, 0x00, 0xdf, 0xf0, 0x96,		// 1004 JSR $DFF096
+	0x4e, 0xb8, 0x80, 0x00,					// 100a JSR $8000.W
+	0x66, 0xf0,								// 100e BNE $1000
+	0x48, 0xe7, 0xc0, 0xc0,					// 1010 MOVEM.L D0-D1/A0-A1,-(A7)
+	0x41, 0xfa, 0x00, 0x0e,					// 1014 LEA 14(PC),A0
+	0xff, 0xff,								// 1018 not an instruction
+	0x4e, 0x75								// 101a RTS
+};
+
+struct CountingVisitor: public Dis68kVisitor {
+	CountingVisitor() : operands(0), targets(0), texts(0), invalid_address(0), invalid_word(0) {}
+
+	void on_instruction(const Dis68kInstruction &inst) { records.push_back(inst); }
+	void on_operand(const Dis68kInstruction &, int, const Dis68kOperand &) { ++operands; }
+	void on_branch_target(const Dis68kInstruction &, uint32_t) { ++targets; }
+	void on_text(const char *, const char *) { ++texts; }
+	void on_invalid(uint32_t address, uint16_t word)
+	{
+		invalid_address = address;
+		invalid_word = word;
+	}
+
+	std::vector<Dis68kInstruction> records;
+	unsigned int operands, targets, texts;
+	uint32_t invalid_address;
+	uint16_t invalid_word;
+};
+
+}
+
+int main()
+{
+	Dis68k dis(code, code + sizeof(code), 0x1000);
+	Dis68kInstruction inst;
+
+	CHECK(dis.decode(inst));
+	CHECK(inst.address == 0x1000 && inst.opcode == 0x3228 && inst.length == 4);
+	CHECK(inst.opnum == OpMOVE && inst.size == SizeWord && inst.flow == FlowSequential && !inst.has_target);
+	CHECK(inst.operand_count == 2);
+	CHECK(inst.operands[0].mode == ModeDisplacement && inst.operands[0].reg == 0 && inst.operands[0].displacement == 16);
+	CHECK(inst.operands[1].mode == ModeDataRegister && inst.operands[1].reg == 1);
+
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpJSR && inst.flow == FlowCall && inst.length == 6);
+	CHECK(inst.operands[0].mode == ModeAbsoluteLong && inst.operands[0].value == 0xdff096);
+	CHECK(inst.has_target && inst.target == 0xdff096);
+
+	/* Short addresses are sign extended. */
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpJSR && inst.operands[0].mode == ModeAbsoluteShort);
+	CHECK(inst.operands[0].value == 0xffff8000);
+	CHECK(inst.has_target && inst.target == 0xffff8000);
+
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpBcc && inst.flow == FlowBranch && inst.condition == 6);
+	CHECK(inst.operand_count == 1 && inst.operands[0].mode == ModeBranchTarget);
+	CHECK(inst.has_target && inst.target == 0x1000);
+
+	/* Register masks are D0 in bit 0, whatever order the opcode holds them in. */
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpMOVEM && inst.size == SizeLong);
+	CHECK(inst.operands[0].mode == ModeRegisterList && inst.operands[0].value == 0x0303);
+	CHECK(inst.operands[1].mode == ModePreDecrement && inst.operands[1].reg == 7);
+
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpLEA && inst.operands[0].mode == ModePCDisplacement);
+	CHECK(inst.operands[0].value == 0x1016 + 14);
+	CHECK(inst.operands[1].mode == ModeAddressRegister && inst.operands[1].reg == 0);
+
+	/* Handlers see the same instructions; text is only composed when asked for. */
+	CountingVisitor visitor;
+	CHECK(dis.seek(0x1000));
+	while( dis.tell() < 0x1018 ) CHECK(dis.decode(visitor));
+	CHECK(visitor.records.size() == 6);
+	CHECK(visitor.operands == 9);
+	CHECK(visitor.targets == 3);
+	CHECK(visitor.texts == 0);
+
+	CHECK(!dis.decode(visitor));
+	CHECK(visitor.invalid_address == 0x1018 && visitor.invalid_word == 0xffff);
+	CHECK(visitor.records.size() == 6);
+
+	CHECK(dis.seek(0x101a));
+	CHECK(dis.decode(inst));
+	CHECK(inst.opnum == OpRTS && inst.flow == FlowReturn && inst.operand_count == 0);
+
+	return check_result("visitor");
+}
@@ -0,0 +1,229 @@
+/*	Program counter trace profiles; see trace.h. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "cycles.h"
+#include "listing.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace {
+
+/* Program counters a worker counts before adding its 32-bit counters into the totals, so that none can overflow. */
+const size_t flush_length = 0xffffffffu;
+
+/* Program counters too few to be worth another worker's counters. */
+const size_t min_share = size_t(1) << 20;
+
+}
+
+TraceProfile::TraceProfile(uint32_t _address, uint32_t _size) :
+	address(_address), size(_size), counts((size_t(_size) + 1) / 2, 0), total_count(0), outside_count(0) {}
+
+void TraceProfile::add(const uint32_t *pcs, size_t count, TraceByteOrder order, unsigned int threads) {
+	const size_t words = counts.size();
+	const size_t workers = std::min<size_t>(worker_count(threads), std::max<size_t>(1, count / min_share));
+	const size_t share = (count + workers - 1) / workers;
+
+	/* Each worker counts its share densely, adding into the totals as it goes; memory is bounded by workers, not trace length. */
+	std::mutex totals_mutex;
+	uint64_t outside = 0;
+	parallel_for(workers, unsigned(workers), [&](size_t k) {
+		const size_t first = std::min(count, k * share), last = std::min(count, first + share);
+		if (first == last) return;
+
+		std::vector<uint32_t> local(words, 0);
+		for (size_t from = first; from < last; from += flush_length) {
+			const size_t to = std::min(last, from + flush_length);
+			uint64_t local_outside = 0;
+			for (size_t i = from; i < to; ++i) {
+				const uint32_t pc = order == TraceByteOrder::BigEndian ? __builtin_bswap32(pcs[i]) : pcs[i];
+				const uint32_t offset = pc - address;
+				if (offset >= size || (offset & 1)) {
+					++local_outside;
+					continue;
+				}
+				++local[offset >> 1];
+			}
+
+			std::lock_guard<std::mutex> lock(totals_mutex);
+			for (size_t w = 0; w < words; ++w) counts[w] += local[w];
+			outside += local_outside;
+			if (to < last) std::fill(local.begin(), local.end(), 0);
+		}
+	});
+
+	total_count += count;
+	outside_count += outside;
+}
+
+bool TraceProfile::load(const char *path, TraceByteOrder order, unsigned int threads) {
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Couldn't open trace %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(fd, &status) < 0) {
+		fprintf(stderr, "Couldn't read trace %s: %s\n", path, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	const size_t length = size_t(status.st_size);
+	if (length % 4) fprintf(stderr, "Trace %s ends with a partial address; ignored\n", path);
+	if (length < 4) {
+		close(fd);
+		return true;
+	}
+
+	void *const mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map trace %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	/* Every slice reads straight through its part of the file. */
+	madvise(mapped, length, MADV_SEQUENTIAL);
+	add((const uint32_t *)mapped, length / 4, order, threads);
+	munmap(mapped, length);
+	return true;
+}
+
+std::vector<uint32_t> TraceProfile::code_entries(const void *begin, const void *end, const Program *program) const {
+	std::vector<bool> covered;
+	if (program) {
+		covered.assign(counts.size(), false);
+		for (const BasicBlock &block : program->blocks) {
+			for (uint32_t a = block.start; a < block.end; a += 2) {
+				const uint32_t offset = a - address;
+				if (offset < size) covered[offset >> 1] = true;
+			}
+		}
+	}
+
+	/* Decode straight on from the last entry, as far as the next executed address, until control leaves. */
+	Dis68k dis(begin, end, address);
+	Dis68kInstruction inst;
+	std::vector<uint32_t> entries;
+	uint32_t next = 0;
+	bool running = false;
+	const auto step = [&]() {
+		dis.seek(next);
+		running = dis.decode(inst) && !dis.overflowed() && inst.flow != FlowJump && inst.flow != FlowReturn;
+		if (running) next += inst.length;
+	};
+
+	for (size_t w = 0; w < counts.size(); ++w) {
+		if (!counts[w] || (program && covered[w])) continue;
+
+		const uint32_t a = address + uint32_t(w * 2);
+		while (running && next - address < a - address) step();
+		if (!running || next != a) {
+			entries.push_back(a);
+			next = a;
+		}
+		step();
+	}
+	return entries;
+}
+
+std::vector<HotBlock> hottest_blocks(const void *begin, const void *end, uint32_t address, const TraceProfile &profile, const Program &program, size_t count, unsigned int threads) {
+	std::vector<BlockCycles> cycles;
+	block_cycles(begin, end, address, program, cycles, threads);
+
+	/* A block in two functions is ranked once. */
+	std::vector<HotBlock> blocks;
+	for (uint32_t b = 0; b < program.blocks.size(); ++b) {
+		const uint64_t executions = profile.hits(program.blocks[b].start);
+		if (!executions) continue;
+		blocks.push_back(HotBlock{b, executions, executions * cycles[b].cycles});
+	}
+	std::sort(blocks.begin(), blocks.end(), [&](const HotBlock &a, const HotBlock &b) {
+		const uint32_t start_a = program.blocks[a.block].start, start_b = program.blocks[b.block].start;
+		return start_a < start_b || (start_a == start_b && a.block < b.block);
+	});
+	blocks.erase(std::unique(blocks.begin(), blocks.end(), [&](const HotBlock &a, const HotBlock &b) {
+		return program.blocks[a.block].start == program.blocks[b.block].start;
+	}), blocks.end());
+
+	const auto hotter = [](const HotBlock &a, const HotBlock &b) {
+		return a.cycles > b.cycles || (a.cycles == b.cycles && (a.executions > b.executions || (a.executions == b.executions && a.block < b.block)));
+	};
+	count = std::min(count, blocks.size());
+	std::partial_sort(blocks.begin(), blocks.begin() + count, blocks.end(), hotter);
+	blocks.resize(count);
+	return blocks;
+}
+
+bool write_hot_blocks(const std::vector<HotBlock> &ranking, const Program &program, FILE *out) {
+	uint64_t total = 0;
+	for (const HotBlock &hot : ranking) total += hot.cycles;
+
+	if (fprintf(out, "rank\tblock\t\tfunction\texecutions\tcycles\t\tshare\n") < 0) return false;
+	for (size_t rank = 0; rank < ranking.size(); ++rank) {
+		const HotBlock &hot = ranking[rank];
+		const BasicBlock &block = program.blocks[hot.block];
+		const double share = total ? 100.0 * double(hot.cycles) / double(total) : 0.0;
+		if (fprintf(out, "%zu\t$%08x\t$%08x\t%llu\t\t%llu\t\t%.1f%%\n", rank + 1, block.start,
+			program.functions[block.function].entry, (unsigned long long)hot.executions, (unsigned long long)hot.cycles, share) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+namespace {
+
+/* Appends hit counts, and the ranks of hot blocks, for write_annotated_listing. */
+class ProfileAnnotator {
+public:
+	ProfileAnnotator(const TraceProfile &_profile, const std::vector<std::pair<uint32_t, size_t>> &_ranks) :
+		profile(_profile), ranks(_ranks) {}
+
+	size_t comment(const Dis68kInstruction &inst, char *comment_s, size_t comment_sz) const {
+		const uint64_t hits = profile.hits(inst.address);
+		if (!hits) return 0;
+
+		const auto found = std::lower_bound(ranks.begin(), ranks.end(), std::make_pair(inst.address, size_t(0)));
+		if (found != ranks.end() && found->first == inst.address) {
+			return snprintf(comment_s, comment_sz, "%llu hit%s, hot block #%zu", (unsigned long long)hits, hits == 1 ? "" : "s", found->second);
+		}
+		return snprintf(comment_s, comment_sz, "%llu hit%s", (unsigned long long)hits, hits == 1 ? "" : "s");
+	}
+
+	template<typename Syntax>
+	bool after(const Dis68kInstruction &, FILE *) const {
+		return true;
+	}
+
+private:
+	const TraceProfile &profile;
+	const std::vector<std::pair<uint32_t, size_t>> &ranks;	// block start and rank, sorted
+};
+
+}
+
+bool write_profiled_listing(const void *begin, const void *end, uint32_t address, const TraceProfile &profile, const std::vector<HotBlock> *ranking, const Program *program, FILE *out, OutputSyntax syntax) {
+	std::vector<std::pair<uint32_t, size_t>> ranks;
+	if (ranking && program) {
+		for (size_t rank = 0; rank < ranking->size(); ++rank) {
+			ranks.push_back(std::make_pair(program->blocks[(*ranking)[rank].block].start, rank + 1));
+		}
+		std::sort(ranks.begin(), ranks.end());
+	}
+
+	ProfileAnnotator annotator(profile, ranks);
+	return write_annotated_listing(begin, end, address, out, syntax, annotator);
+}
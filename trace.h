@@ -0,0 +1,109 @@
+#if !defined( TRACE_H )
+#define TRACE_H 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "analysis.h"
+#include "dis68k.h"
+
+/// Byte order of the 32-bit program counters in a trace file.
+enum class TraceByteOrder {
+	LittleEndian,	// as written by an emulator on x86 or ARM hosts
+	BigEndian		// as the 68000 stores them
+};
+
+/*!
+	Execution counts for every word of an image, gathered from program counter
+	traces: a dense array of one counter per word, so that an address seen in a
+	trace is definitely the start of an instruction.
+*/
+class TraceProfile
+{
+public:
+	/// Profiles the image of @c _size bytes located at @c _address.
+	TraceProfile(uint32_t _address, uint32_t _size);
+
+	/*!
+		Adds the trace at @c path, a flat file of 32-bit program counters,
+		which is mapped and counted in parallel on @c threads threads (0 for
+		one per hardware thread), or on fewer if it is short. Each thread counts
+		its share into 32-bit counters of its own, added into the totals often
+		enough that none can overflow.
+
+		@returns @c false, having printed a diagnostic, if the file can't be read.
+	*/
+	bool load(const char *path, TraceByteOrder order = TraceByteOrder::LittleEndian, unsigned int threads = 0);
+
+	/// Adds @c count program counters from @c pcs, as load does.
+	void add(const uint32_t *pcs, size_t count, TraceByteOrder order = TraceByteOrder::LittleEndian, unsigned int threads = 0);
+
+	uint64_t hits(uint32_t _address) const
+	{
+		const uint32_t offset = _address - address;
+		if( offset >= size || (offset & 1) ) return 0;
+		return counts[offset >> 1];
+	}
+
+	bool executed(uint32_t _address) const
+	{
+		return hits(_address) != 0;
+	}
+
+	/// @returns The number of program counters counted.
+	uint64_t total() const
+	{
+		return total_count;
+	}
+
+	/// @returns The number of program counters that were odd or outside the image.
+	uint64_t outside() const
+	{
+		return outside_count;
+	}
+
+	/*!
+		@returns Executed addresses that aren't in any block of @c program, or
+			all executed addresses if it is null, less those that decoding
+			straight on from an earlier one, through the image [@c begin,
+			@c end) this profile covers, reaches before a jump or return. They
+			make entry points for analyse_program that bring all executed code
+			into it.
+	*/
+	std::vector<uint32_t> code_entries(const void *begin, const void *end, const Program *program) const;
+
+private:
+	uint32_t address, size;
+	std::vector<uint64_t> counts;		// one per word
+	uint64_t total_count, outside_count;
+};
+
+/// A block of a Program with its share of a profile.
+struct HotBlock {
+	uint32_t block;			// index into Program::blocks
+	uint64_t executions;	// hits on its first instruction
+	uint64_t cycles;		// executions times the block's cycles; see cycles.h
+};
+
+/*!
+	Ranks the blocks of @c program, analysed from the image [@c begin, @c end)
+	located at @c address, by the time @c profile says was spent in them, and
+	returns the first @c count.
+*/
+std::vector<HotBlock> hottest_blocks(const void *begin, const void *end, uint32_t address, const TraceProfile &profile, const Program &program, size_t count, unsigned int threads = 0);
+
+/// Prints @c ranking as a table, hottest first.
+bool write_hot_blocks(const std::vector<HotBlock> &ranking, const Program &program, FILE *out);
+
+/*!
+	Writes the listing of write_listing with each executed instruction's hit
+	count as a comment, and each block of @c ranking marked with its rank.
+
+	@returns @c false on a write error.
+*/
+bool write_profiled_listing(const void *begin, const void *end, uint32_t address, const TraceProfile &profile, const std::vector<HotBlock> *ranking, const Program *program, FILE *out, OutputSyntax syntax = OutputSyntax::Motorola);
+
+#endif // TRACE_H
@@ -0,0 +1,95 @@
+/*	68000 exception vector table reading. */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "vectors.h"
+
+namespace {
+
+const unsigned int vector_count = 256;
+
+/* Past the fixed vectors, the traps and the reserved block, the table may be cut short. */
+const unsigned int optional_vectors = 64;
+
+const char *const fixed_names[25] = {
+	"reset SSP",				"reset PC",				"bus error",				"address error",
+	"illegal instruction",		"zero divide",			"CHK",						"TRAPV",
+	"privilege violation",		"trace",				"line 1010 emulator",		"line 1111 emulator",
+	"reserved",					"reserved",				"reserved",					"uninitialised interrupt",
+	"reserved",					"reserved",				"reserved",					"reserved",
+	"reserved",					"reserved",				"reserved",					"reserved",
+	"spurious interrupt"
+};
+
+}
+
+size_t read_vector_table(const void *begin, const void *end, uint32_t romstart, std::vector<ExceptionVector> &vectors, uint32_t address_mask) {
+	const uint8_t *const data = (const uint8_t *)begin;
+	const uint32_t size = uint32_t((const uint8_t *)end - data);
+
+	/* The table occupies up to 1 KB, but a short image may hold only part of it. */
+	const unsigned int count = std::min(vector_count, size / 4);
+
+	/* A handler lies past its own vector, inside the image. */
+	const auto plausible = [=](unsigned int number, uint32_t handler) {
+		return !(handler & 1) &&
+			handler - romstart >= (number + 1) * 4 &&
+			handler - romstart < size;
+	};
+	const auto vector = [=](unsigned int number) {
+		const uint8_t *v = &data[number * 4];
+		return uint32_t((v[0] << 24) | (v[1] << 16) | (v[2] << 8) | v[3]) & address_mask;
+	};
+
+	if (count < 2 || !plausible(1, vector(1))) return 0;
+
+	/*
+		The table ends where code starts, so never at or beyond the lowest
+		handler; and once past the optional vectors, it ends at the first that
+		is implausible, as cartridge headers often follow a short table.
+	*/
+	uint32_t lowest = size;
+	size_t accepted = 0;
+	for (unsigned int number = 1; number < count && number * 4 < lowest; ++number) {
+		const uint32_t handler = vector(number);
+		if (!plausible(number, handler)) {
+			if (number >= optional_vectors) break;
+			continue;
+		}
+
+		vectors.push_back(ExceptionVector{number, handler});
+		lowest = std::min(lowest, handler - romstart);
+		++accepted;
+	}
+	return accepted;
+}
+
+std::vector<uint32_t> vector_entry_points(const std::vector<ExceptionVector> &vectors) {
+	std::vector<uint32_t> entry_points;
+	entry_points.reserve(vectors.size());
+	for (const ExceptionVector &v : vectors) {
+		entry_points.push_back(v.handler);
+	}
+
+	/* Unused vectors commonly share a single default handler. */
+	std::sort(entry_points.begin(), entry_points.end());
+	entry_points.erase(std::unique(entry_points.begin(), entry_points.end()), entry_points.end());
+	return entry_points;
+}
+
+void vector_name(unsigned int number, char *out_s, size_t out_sz) {
+	if (number < 25) {
+		snprintf(out_s, out_sz, "%s", fixed_names[number]);
+	} else if (number < 32) {
+		snprintf(out_s, out_sz, "level %u autovector", number - 24);
+	} else if (number < 48) {
+		snprintf(out_s, out_sz, "TRAP #%u", number - 32);
+	} else if (number < 64) {
+		snprintf(out_s, out_sz, "reserved");
+	} else {
+		snprintf(out_s, out_sz, "user interrupt %u", number - 64);
+	}
+}
@@ -0,0 +1,44 @@
+#if !defined( VECTORS_H )
+#define VECTORS_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+struct ExceptionVector {
+	unsigned int number;	// 1 to 255
+	uint32_t handler;
+};
+
+/*!
+	Reads the 68000 exception vector table from the start of the image
+	[@c begin, @c end), which is located at @c romstart, and appends to
+	@c vectors every vector whose handler is plausible: even, inside the image
+	and beyond the vector itself. Vector 0, the reset stack pointer, is never
+	a handler.
+
+	The table is only trusted if the reset PC (vector 1) is plausible; if it
+	is not, nothing is appended. It is taken to end before the lowest handler
+	found, and, after vector 63, at the first implausible vector, so that
+	data following a short table, such as a cartridge header, isn't read as
+	vectors.
+
+	@param address_mask Applied to each vector before validation; the 68000
+		ignores the top byte of addresses.
+	@returns The number of vectors appended.
+*/
+size_t read_vector_table(const void *begin, const void *end, uint32_t romstart, std::vector<ExceptionVector> &vectors, uint32_t address_mask = 0x00ffffff);
+
+/*!
+	@returns The distinct handler addresses of @c vectors, in ascending order,
+		for use as decoding entry points.
+*/
+std::vector<uint32_t> vector_entry_points(const std::vector<ExceptionVector> &vectors);
+
+/*!
+	Prints the conventional name of vector @c number, e.g. "bus error" or "TRAP #3", to @c out_s.
+*/
+void vector_name(unsigned int number, char *out_s, size_t out_sz);
+
+#endif // VECTORS_H
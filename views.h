@@ -0,0 +1,151 @@
+#if !defined( VIEWS_H )
+#define VIEWS_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+	Input views: the ways in which Dis68k can find the bytes of an image.
+
+	A view maps 68000 addresses onto backing memory without copying it. Each
+	provides contains(), which tests an address, and byte() and word(), which
+	fetch big-endian data, returning false if any of it lies outside the image.
+	Dis68k is specialised on its view type so each fetch path is inlined.
+*/
+
+/// A single big-endian image, as read straight from a file.
+class ContiguousView
+{
+public:
+	ContiguousView(const void *_begin, const void *_end, uint32_t _base)
+	{
+		data = (const uint8_t *)_begin;
+		size = uint32_t( (const uint8_t *)_end - data );
+		base = _base;
+	}
+
+	bool contains(uint32_t address) const
+	{
+		return address - base < size;
+	}
+
+	bool byte(uint32_t address, uint8_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size ) return false;
+
+		res = data[offset];
+		return true;
+	}
+
+	bool word(uint32_t address, uint16_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size - 1 || size < 2 ) return false;
+
+		res = uint16_t( (data[offset] << 8) | data[offset + 1] );
+		return true;
+	}
+
+private:
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t base;
+};
+
+/// An image split across two 8-bit devices, one holding even bytes and the other odd.
+class InterleavedView
+{
+public:
+	/*!
+		@param _even Contents of the device holding even addresses (D8-D15).
+		@param _odd Contents of the device holding odd addresses (D0-D7).
+		@param _device_size The size of each device, in bytes.
+	*/
+	InterleavedView(const void *_even, const void *_odd, uint32_t _device_size, uint32_t _base)
+	{
+		even = (const uint8_t *)_even;
+		odd = (const uint8_t *)_odd;
+		size = _device_size * 2;
+		base = _base;
+	}
+
+	bool contains(uint32_t address) const
+	{
+		return address - base < size;
+	}
+
+	bool byte(uint32_t address, uint8_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size ) return false;
+
+		res = ( offset & 1 ) ? odd[offset >> 1] : even[offset >> 1];
+		return true;
+	}
+
+	bool word(uint32_t address, uint16_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size - 1 || size < 2 ) return false;
+
+		const uint32_t index = offset >> 1;
+		if( offset & 1 )
+		{
+			res = uint16_t( (odd[index] << 8) | even[index + 1] );
+		}
+		else
+		{
+			res = uint16_t( (even[index] << 8) | odd[index] );
+		}
+		return true;
+	}
+
+private:
+	const uint8_t *even;
+	const uint8_t *odd;
+	uint32_t size;
+	uint32_t base;
+};
+
+/// A single image stored with the bytes of each word swapped, i.e. little-endian words.
+class WordSwappedView
+{
+public:
+	WordSwappedView(const void *_begin, const void *_end, uint32_t _base)
+	{
+		data = (const uint8_t *)_begin;
+		size = uint32_t( (const uint8_t *)_end - data ) & ~1u;
+		base = _base;
+	}
+
+	bool contains(uint32_t address) const
+	{
+		return address - base < size;
+	}
+
+	bool byte(uint32_t address, uint8_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size ) return false;
+
+		res = data[offset ^ 1];
+		return true;
+	}
+
+	bool word(uint32_t address, uint16_t &res) const
+	{
+		const uint32_t offset = address - base;
+		if( offset >= size - 1 || size < 2 ) return false;
+
+		res = uint16_t( (data[offset ^ 1] << 8) | data[(offset + 1) ^ 1] );
+		return true;
+	}
+
+private:
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t base;
+};
+
+#endif // VIEWS_H